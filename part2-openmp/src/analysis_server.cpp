@@ -0,0 +1,394 @@
+#include "analysis_server.hpp"
+#include "text_encoding.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <omp.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid socket path: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;     // Клиент ушел - ответ некому отдавать
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+std::string formatCounts(TextEncoding encoding, size_t characters,
+                         const BookAnalyzer::LetterHistogram& letters) {
+    std::uint64_t total = 0;
+    for (auto count : letters) {
+        total += count;
+    }
+    
+    std::ostringstream out;
+    out << "OK " << TextDecoder::name(encoding) << " " << characters << " " << total;
+    for (auto count : letters) {
+        out << " " << count;
+    }
+    out << "\n";
+    return out.str();
+}
+
+} // namespace
+
+struct AnalysisServer::Client {
+    int fd = -1;
+    std::string buffer;
+    bool closed = false;
+};
+
+struct AnalysisServer::Request {
+    enum class Kind { File, Text, Stats, Shutdown, Invalid };
+    
+    int fd = -1;
+    Kind kind = Kind::Invalid;
+    std::string payload;        // Путь, текст или сообщение об ошибке
+    size_t bytes = 0;           // Размер текста (для файла - по stat)
+    Clock::time_point received;
+    std::string response;
+};
+
+AnalysisServer::AnalysisServer(const ServerOptions& options)
+    : options_(options),
+      threads_(options.threads > 0 ? options.threads : omp_get_max_threads()) {
+    
+    sockaddr_un address = socketAddress(options_.socketPath);
+    
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        throw std::runtime_error(std::string("Cannot create socket: ") + std::strerror(errno));
+    }
+    
+    // Сокет, оставшийся от прошлого запуска, мешает bind
+    unlink(options_.socketPath.c_str());
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd_, 64) != 0) {
+        std::string reason = std::strerror(errno);
+        close(listenFd_);
+        throw std::runtime_error("Cannot listen on " + options_.socketPath + ": " + reason);
+    }
+    
+    threadHistograms_.resize(threads_);
+    latencies_.reserve(options_.latencyHistory);
+}
+
+AnalysisServer::~AnalysisServer() {
+    for (auto& client : clients_) {
+        close(client.fd);
+    }
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        unlink(options_.socketPath.c_str());
+    }
+}
+
+void AnalysisServer::run() {
+    while (!stopping_) {
+        std::vector<pollfd> fds;
+        fds.push_back({listenFd_, POLLIN, 0});
+        for (const auto& client : clients_) {
+            fds.push_back({client.fd, POLLIN, 0});
+        }
+        
+        // Таймаут - чтобы заметить stop() из другого потока
+        int ready = poll(fds.data(), fds.size(), 100);
+        if (ready <= 0) {
+            continue;
+        }
+        
+        std::vector<Request> batch;
+        for (size_t i = 0; i < clients_.size(); ++i) {
+            if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+                readClient(clients_[i], batch);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            acceptClients();
+        }
+        
+        // Окно пакета: запросы, пришедшие чуть позже, считаются вместе
+        if (!batch.empty() && options_.batchWindowMicros > 0) {
+            std::vector<pollfd> more;
+            for (const auto& client : clients_) {
+                if (!client.closed) {
+                    more.push_back({client.fd, POLLIN, 0});
+                }
+            }
+            timespec window{options_.batchWindowMicros / 1000000,
+                            static_cast<long>(options_.batchWindowMicros % 1000000) * 1000};
+            if (!more.empty() && ppoll(more.data(), more.size(), &window, nullptr) > 0) {
+                for (const auto& entry : more) {
+                    if (entry.revents & (POLLIN | POLLHUP | POLLERR)) {
+                        auto client = std::find_if(clients_.begin(), clients_.end(),
+                                                   [&](const Client& c) { return c.fd == entry.fd; });
+                        readClient(*client, batch);
+                    }
+                }
+            }
+        }
+        
+        if (!batch.empty()) {
+            processBatch(batch);
+        }
+        
+        // Закрываем ушедших клиентов после ответа, чтобы номер
+        // дескриптора не достался новому соединению раньше времени
+        for (auto& client : clients_) {
+            if (client.closed) {
+                close(client.fd);
+            }
+        }
+        clients_.erase(std::remove_if(clients_.begin(), clients_.end(),
+                                      [](const Client& c) { return c.closed; }),
+                       clients_.end());
+    }
+}
+
+void AnalysisServer::acceptClients() {
+    int fd = accept(listenFd_, nullptr, nullptr);
+    if (fd >= 0) {
+        clients_.push_back(Client{fd, "", false});
+    }
+}
+
+void AnalysisServer::readClient(Client& client, std::vector<Request>& batch) {
+    char chunk[64 * 1024];
+    ssize_t n = recv(client.fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+    if (n <= 0) {
+        if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+            client.closed = true;
+        }
+        return;
+    }
+    client.buffer.append(chunk, static_cast<size_t>(n));
+    
+    // Разбор всех полных запросов из буфера
+    while (true) {
+        size_t newline = client.buffer.find('\n');
+        if (newline == std::string::npos) {
+            break;
+        }
+        std::string line = client.buffer.substr(0, newline);
+        
+        Request request;
+        request.fd = client.fd;
+        size_t consumed = newline + 1;
+        
+        if (line.compare(0, 5, "TEXT ") == 0) {
+            const char* digits = line.c_str() + 5;
+            char* end = nullptr;
+            errno = 0;
+            unsigned long long length = std::strtoull(digits, &end, 10);
+            if (end == digits || *end != '\0' || *digits == '-' || errno == ERANGE ||
+                length > options_.maxTextBytes) {
+                request.payload = "Invalid text length: " + line.substr(5);
+                request.received = Clock::now();
+                batch.push_back(std::move(request));
+                client.buffer.clear();
+                client.closed = true;
+                break;
+            }
+            if (client.buffer.size() - consumed < length) {
+                break;      // Текст еще не дочитан
+            }
+            request.kind = Request::Kind::Text;
+            request.payload = client.buffer.substr(consumed, length);
+            request.bytes = length;
+            consumed += length;
+        } else if (line.compare(0, 5, "FILE ") == 0) {
+            request.kind = Request::Kind::File;
+            request.payload = line.substr(5);
+            struct stat info;
+            request.bytes = stat(request.payload.c_str(), &info) == 0 ? info.st_size : 0;
+        } else if (line == "STATS") {
+            request.kind = Request::Kind::Stats;
+        } else if (line == "SHUTDOWN") {
+            request.kind = Request::Kind::Shutdown;
+        } else {
+            request.payload = "Unknown command: " + line;
+        }
+        
+        client.buffer.erase(0, consumed);
+        request.received = Clock::now();
+        batch.push_back(std::move(request));
+    }
+}
+
+void AnalysisServer::processBatch(std::vector<Request>& batch) {
+    // Анализ одного запроса; threads == 1 - внутри общей параллельной области
+    auto analyze = [this](Request& request, int threads,
+                          BookAnalyzer::LetterHistogram& letters) {
+        try {
+            std::string fileText;
+            if (request.kind == Request::Kind::File) {
+                fileText = BookAnalyzer::readFileToString(request.payload);
+            }
+            const std::string& text = request.kind == Request::Kind::File ? fileText
+                                                                           : request.payload;
+            TextEncoding encoding = TextDecoder::detect(text);
+            
+            letters.fill(0);
+            if (threads == 1) {
+                TextDecoder::accumulate(text.data(), text.size(), text.size(), encoding, letters);
+            } else {
+                letters = TextDecoder::countLetters(text, encoding, threads);
+            }
+            request.response = formatCounts(encoding, text.size(), letters);
+        } catch (const std::exception& e) {
+            request.response = std::string("ERR ") + e.what() + "\n";
+        }
+    };
+    
+    std::vector<size_t> small;
+    std::vector<size_t> large;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Request& request = batch[i];
+        switch (request.kind) {
+            case Request::Kind::File:
+            case Request::Kind::Text:
+                (request.bytes < options_.smallRequestBytes ? small : large).push_back(i);
+                break;
+            case Request::Kind::Stats: {
+                LatencyStats stats = latency();
+                std::ostringstream out;
+                out << "OK requests=" << stats.requests << " p50=" << stats.p50
+                    << " p90=" << stats.p90 << " p99=" << stats.p99
+                    << " max=" << stats.max << "\n";
+                request.response = out.str();
+                break;
+            }
+            case Request::Kind::Shutdown:
+                request.response = "OK\n";
+                stopping_ = true;
+                break;
+            default:
+                request.response = "ERR " + request.payload + "\n";
+                break;
+        }
+    }
+    
+    // Малые запросы - по запросу на поток в одной параллельной области
+    if (!small.empty()) {
+        int threads = static_cast<int>(std::min<size_t>(threads_, small.size()));
+        #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+        for (size_t k = 0; k < small.size(); ++k) {
+            analyze(batch[small[k]], 1, threadHistograms_[omp_get_thread_num()]);
+        }
+    }
+    for (size_t i : large) {
+        analyze(batch[i], threads_, threadHistograms_[0]);
+    }
+    
+    // Ответы в порядке поступления: у соединения они не переставляются
+    for (const auto& request : batch) {
+        sendAll(request.fd, request.response);
+        if (request.kind == Request::Kind::File || request.kind == Request::Kind::Text) {
+            recordLatency(std::chrono::duration<double, std::micro>(
+                Clock::now() - request.received).count());
+        }
+    }
+}
+
+void AnalysisServer::recordLatency(double micros) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    if (latencies_.size() < options_.latencyHistory) {
+        latencies_.push_back(micros);
+    } else {
+        latencies_[requestCount_ % options_.latencyHistory] = micros;
+    }
+    requestCount_++;
+}
+
+LatencyStats AnalysisServer::latency() const {
+    std::vector<double> sorted;
+    LatencyStats stats;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        sorted = latencies_;
+        stats.requests = requestCount_;
+    }
+    if (sorted.empty()) {
+        return stats;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    
+    // Перцентиль по ближайшему рангу
+    auto percentile = [&sorted](double q) {
+        size_t rank = static_cast<size_t>(std::ceil(q * sorted.size()));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    };
+    stats.p50 = percentile(0.50);
+    stats.p90 = percentile(0.90);
+    stats.p99 = percentile(0.99);
+    stats.max = sorted.back();
+    return stats;
+}
+
+std::string AnalysisServer::request(const std::string& socketPath, const std::string& command,
+                                    const std::string& body) {
+    sockaddr_un address = socketAddress(socketPath);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::string reason = std::strerror(errno);
+        if (fd >= 0) close(fd);
+        throw std::runtime_error("Cannot connect to " + socketPath + ": " + reason);
+    }
+    
+    sendAll(fd, command + "\n" + body);
+    
+    std::string response;
+    char c;
+    while (recv(fd, &c, 1, 0) == 1 && c != '\n') {
+        response += c;
+    }
+    close(fd);
+    return response;
+}
+
+BookAnalyzer::AnalysisResult AnalysisServer::parseResponse(const std::string& response) {
+    std::istringstream in(response);
+    std::string status;
+    std::string encoding;
+    std::uint64_t characters = 0;
+    std::uint64_t total = 0;
+    in >> status;
+    if (status != "OK" || !(in >> encoding >> characters >> total)) {
+        throw std::runtime_error("Server error: " + response);
+    }
+    
+    BookAnalyzer::LetterHistogram letters{};
+    for (auto& count : letters) {
+        if (!(in >> count)) {
+            throw std::runtime_error("Malformed server response: " + response);
+        }
+    }
+    return BookAnalyzer::resultFromHistogram(letters, characters);
+}
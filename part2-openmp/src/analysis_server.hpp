@@ -0,0 +1,82 @@
+#ifndef ANALYSIS_SERVER_HPP
+#define ANALYSIS_SERVER_HPP
+
+#include "book_analyzer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ServerOptions {
+    std::string socketPath;
+    int threads = 0;                    // 0 - omp_get_max_threads()
+    int batchWindowMicros = 200;        // Ожидание попутных запросов после первого
+    size_t smallRequestBytes = 256 * 1024;  // Меньшие запросы считаются пакетом
+    size_t latencyHistory = 1 << 16;    // Запросов в окне перцентилей
+    size_t maxTextBytes = 64 << 20;     // Наибольшая длина в TEXT
+};
+
+struct LatencyStats {
+    std::uint64_t requests = 0;
+    double p50 = 0.0;                   // Микросекунды
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Долгоживущий анализатор на Unix-сокете. Протокол строковый, запросы
+// одного соединения обрабатываются по порядку:
+//   FILE <путь>\n        - буквы файла (кодировка определяется)
+//   TEXT <длина>\n<байты> - буквы переданного текста
+//   STATS\n               - перцентили задержки
+//   SHUTDOWN\n            - остановка сервера
+// Ответ на анализ: OK <кодировка> <символов> <букв> <33 счетчика>\n,
+// на ошибку: ERR <сообщение>\n. Неверная или превышающая maxTextBytes
+// длина TEXT закрывает соединение после ответа ERR: границу следующего
+// запроса в потоке уже не найти.
+// Готовые запросы всех соединений собираются в пакет: малые считаются
+// одной параллельной областью (по запросу на поток, гистограммы потоков
+// выделены один раз), большие - каждый всеми потоками. Команда OpenMP
+// между пакетами не пересоздается
+class AnalysisServer {
+public:
+    explicit AnalysisServer(const ServerOptions& options);
+    ~AnalysisServer();
+    
+    // Цикл обработки до SHUTDOWN или stop()
+    void run();
+    void stop() { stopping_ = true; }
+    
+    LatencyStats latency() const;
+    
+    // Клиент: отправка запроса и ответ сервера (без перевода строки)
+    static std::string request(const std::string& socketPath, const std::string& command,
+                               const std::string& body = "");
+    
+    // Разбор ответа на анализ
+    static BookAnalyzer::AnalysisResult parseResponse(const std::string& response);
+    
+private:
+    struct Client;
+    struct Request;
+    
+    void acceptClients();
+    void readClient(Client& client, std::vector<Request>& batch);
+    void processBatch(std::vector<Request>& batch);
+    void recordLatency(double micros);
+    
+    ServerOptions options_;
+    int listenFd_ = -1;
+    int threads_;
+    std::atomic<bool> stopping_{false};
+    std::vector<Client> clients_;
+    std::vector<BookAnalyzer::LetterHistogram> threadHistograms_;
+    
+    // Задержки под мьютексом: latency() может вызываться из другого потока
+    mutable std::mutex statsMutex_;
+    std::vector<double> latencies_;     // Кольцевой буфер
+    std::uint64_t requestCount_ = 0;
+};
+
+#endif // ANALYSIS_SERVER_HPP
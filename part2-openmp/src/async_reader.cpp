@@ -0,0 +1,542 @@
+#include "async_reader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <omp.h>
+
+namespace {
+
+// Чтение length байтов файла со смещения offset в буфер с номером buffer
+struct ReadRequest {
+    int fd;
+    std::uint64_t offset;
+    char* data;
+    size_t length;
+    unsigned buffer;
+};
+
+struct ReadCompletion {
+    unsigned buffer;
+    long result;        // Прочитано байтов или -errno
+};
+
+class ReadQueue {
+public:
+    virtual ~ReadQueue() = default;
+    
+    // Постановка в очередь; submit() отправляет накопленное
+    virtual void push(const ReadRequest& request) = 0;
+    virtual void submit() {}
+    
+    // Ожидание одного завершенного чтения
+    virtual ReadCompletion wait() = 0;
+};
+
+std::string systemError(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// io_uring через системные вызовы (без liburing): кольцо отправки,
+// кольцо завершений и массив SQE отображаются в память процесса
+class UringQueue : public ReadQueue {
+public:
+    UringQueue(unsigned entries, char* buffers, size_t bufferBytes, unsigned count) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_ < 0) {
+            throw std::runtime_error(systemError("io_uring_setup failed"));
+        }
+        
+        sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) {
+            sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+        }
+        
+        sqRing_ = map(sqSize_, IORING_OFF_SQ_RING);
+        cqRing_ = singleMmap ? sqRing_ : map(cqSize_, IORING_OFF_CQ_RING);
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqesSize_, IORING_OFF_SQES));
+        
+        char* sq = static_cast<char*>(sqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        
+        char* cq = static_cast<char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        
+        // Зарегистрированные буферы избавляют ядро от отображения страниц
+        // на каждом чтении. Без них (лимит RLIMIT_MEMLOCK) - обычный READ
+        std::vector<iovec> iov(count);
+        for (unsigned b = 0; b < count; ++b) {
+            iov[b].iov_base = buffers + b * bufferBytes;
+            iov[b].iov_len = bufferBytes;
+        }
+        fixed_ = syscall(__NR_io_uring_register, ring_, IORING_REGISTER_BUFFERS,
+                         iov.data(), count) == 0;
+    }
+    
+    ~UringQueue() override {
+        if (sqes_) munmap(sqes_, sqesSize_);
+        if (cqRing_ && cqRing_ != sqRing_) munmap(cqRing_, cqSize_);
+        if (sqRing_) munmap(sqRing_, sqSize_);
+        close(ring_);
+    }
+    
+    void push(const ReadRequest& request) override {
+        // Кольцо не короче числа буферов, поэтому место всегда есть
+        unsigned tail = *sqTail_;
+        unsigned index = tail & sqMask_;
+        
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = fixed_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe.fd = request.fd;
+        sqe.off = request.offset;
+        sqe.addr = reinterpret_cast<std::uint64_t>(request.data);
+        sqe.len = static_cast<unsigned>(request.length);
+        sqe.buf_index = fixed_ ? static_cast<std::uint16_t>(request.buffer) : 0;
+        sqe.user_data = request.buffer;
+        
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        unsubmitted_++;
+    }
+    
+    void submit() override {
+        while (unsubmitted_ > 0) {
+            int sent = enter(unsubmitted_, 0, 0);
+            unsubmitted_ -= static_cast<unsigned>(sent);
+        }
+    }
+    
+    ReadCompletion wait() override {
+        while (true) {
+            unsigned head = *cqHead_;
+            if (head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                ReadCompletion done{static_cast<unsigned>(cqe.user_data), cqe.res};
+                __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+                return done;
+            }
+            
+            // Отправка накопленного и ожидание хотя бы одного завершения
+            enter(unsubmitted_, 1, IORING_ENTER_GETEVENTS);
+            unsubmitted_ = 0;
+        }
+    }
+    
+private:
+    void* map(size_t size, off_t offset) {
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring_, offset);
+        if (ptr == MAP_FAILED) {
+            throw std::runtime_error(systemError("io_uring mmap failed"));
+        }
+        return ptr;
+    }
+    
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        while (true) {
+            long ret = syscall(__NR_io_uring_enter, ring_, toSubmit, minComplete, flags,
+                               nullptr, 0);
+            if (ret >= 0) {
+                return static_cast<int>(ret);
+            }
+            if (errno != EINTR) {
+                throw std::runtime_error(systemError("io_uring_enter failed"));
+            }
+        }
+    }
+    
+    int ring_ = -1;
+    bool fixed_ = false;
+    unsigned unsubmitted_ = 0;
+    
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqSize_ = 0;
+    size_t cqSize_ = 0;
+    size_t sqesSize_ = 0;
+    
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+// Запасной вариант: пул потоков с блокирующим pread
+class ThreadPoolQueue : public ReadQueue {
+public:
+    explicit ThreadPoolQueue(int threads) {
+        for (int t = 0; t < std::max(1, threads); ++t) {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+    
+    ~ThreadPoolQueue() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        requestReady_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+    
+    void push(const ReadRequest& request) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_.push_back(request);
+        }
+        requestReady_.notify_one();
+    }
+    
+    ReadCompletion wait() override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        completionReady_.wait(lock, [this] { return !completions_.empty(); });
+        ReadCompletion done = completions_.front();
+        completions_.pop_front();
+        return done;
+    }
+    
+private:
+    void run() {
+        while (true) {
+            ReadRequest request;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                requestReady_.wait(lock, [this] { return stop_ || !requests_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                request = requests_.front();
+                requests_.pop_front();
+            }
+            
+            long result = pread(request.fd, request.data, request.length,
+                                static_cast<off_t>(request.offset));
+            
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                completions_.push_back({request.buffer, result < 0 ? -errno : result});
+            }
+            completionReady_.notify_one();
+        }
+    }
+    
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable requestReady_;
+    std::condition_variable completionReady_;
+    std::deque<ReadRequest> requests_;
+    std::deque<ReadCompletion> completions_;
+    bool stop_ = false;
+};
+
+} // namespace
+
+AsyncCorpusReader::AsyncCorpusReader(const AsyncReaderOptions& options)
+    : options_(options), backend_(options.backend) {
+    
+    if (options_.blockBytes == 0 || options_.queueDepth == 0) {
+        throw std::invalid_argument("Block size and queue depth must be positive");
+    }
+    if (backend_ == ReaderBackend::Auto) {
+        backend_ = ioUringAvailable() ? ReaderBackend::IoUring : ReaderBackend::ThreadPool;
+    } else if (backend_ == ReaderBackend::IoUring && !ioUringAvailable()) {
+        throw std::runtime_error("io_uring is not available on this system");
+    }
+}
+
+bool AsyncCorpusReader::ioUringAvailable() {
+    // Ядро может не знать io_uring или запрещать его (io_uring_disabled, seccomp)
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    long ring = syscall(__NR_io_uring_setup, 1, &params);
+    if (ring < 0) {
+        return false;
+    }
+    close(static_cast<int>(ring));
+    return true;
+}
+
+std::string AsyncCorpusReader::backendName(ReaderBackend backend) {
+    switch (backend) {
+        case ReaderBackend::IoUring:
+            return "io_uring";
+        case ReaderBackend::ThreadPool:
+            return "threads";
+        default:
+            return "auto";
+    }
+}
+
+ReaderBackend AsyncCorpusReader::parseBackend(const std::string& name) {
+    if (name == "auto") return ReaderBackend::Auto;
+    if (name == "io_uring" || name == "uring") return ReaderBackend::IoUring;
+    if (name == "threads") return ReaderBackend::ThreadPool;
+    throw std::invalid_argument("Unknown reader: " + name);
+}
+
+std::vector<CorpusFileCount> AsyncCorpusReader::count(const std::vector<std::string>& files) {
+    std::vector<CorpusFileCount> results(files.size());
+    for (size_t f = 0; f < files.size(); ++f) {
+        results[f].path = files[f];
+        results[f].encoding = options_.encoding;
+    }
+    
+    struct FileState {
+        int fd = -1;
+        size_t blocks = 0;
+        size_t readsLeft = 0;
+    };
+    std::vector<FileState> state(files.size());
+    
+    // Блок в буфере: какой файл, где и сколько байтов уже прочитано
+    struct BufferState {
+        size_t file = 0;
+        size_t block = 0;
+        size_t length = 0;          // Байтов блока
+        size_t readLength = 0;      // С байтом перекрытия
+        size_t filled = 0;
+    };
+    
+    const size_t blockBytes = options_.blockBytes;
+    const size_t bufferBytes = blockBytes + 1;
+    const unsigned depth = options_.queueDepth;
+    std::vector<char> storage(bufferBytes * depth);
+    std::vector<BufferState> buffers(depth);
+    
+    std::unique_ptr<ReadQueue> queue;
+    if (backend_ == ReaderBackend::IoUring) {
+        queue = std::make_unique<UringQueue>(depth, storage.data(), bufferBytes, depth);
+    } else {
+        queue = std::make_unique<ThreadPoolQueue>(options_.ioThreads);
+    }
+    
+    // Очередь блоков (файл, номер блока); сначала первые блоки всех файлов
+    std::deque<std::pair<size_t, size_t>> pending;
+    for (size_t f = 0; f < files.size(); ++f) {
+        pending.emplace_back(f, 0);
+    }
+    
+    // Общие с задачами подсчета: свободные буферы и файлы с известной кодировкой
+    std::mutex shared;
+    std::vector<unsigned> freeBuffers;
+    for (unsigned b = depth; b-- > 0; ) {
+        freeBuffers.push_back(b);
+    }
+    std::vector<size_t> detected;
+    size_t awaitingDetection = 0;
+    
+    std::string error;
+    int threads = options_.threads > 0 ? options_.threads : omp_get_max_threads();
+    
+    auto issue = [&](unsigned b) {
+        BufferState& buffer = buffers[b];
+        char* data = storage.data() + b * bufferBytes;
+        queue->push({state[buffer.file].fd,
+                     buffer.block * blockBytes + buffer.filled,
+                     data + buffer.filled,
+                     buffer.readLength - buffer.filled,
+                     b});
+    };
+    
+    auto scheduleRest = [&](size_t f) {
+        for (size_t block = 1; block < state[f].blocks; ++block) {
+            pending.emplace_back(f, block);
+        }
+    };
+    
+    #pragma omp parallel num_threads(threads)
+    #pragma omp single
+    {
+        size_t inFlight = 0;
+        
+        while (true) {
+            try {
+                {
+                    std::lock_guard<std::mutex> lock(shared);
+                    for (size_t f : detected) {
+                        scheduleRest(f);
+                        awaitingDetection--;
+                    }
+                    detected.clear();
+                }
+                
+                // Очередь чтений заполняется до числа свободных буферов
+                while (error.empty() && !pending.empty()) {
+                    unsigned b;
+                    {
+                        std::lock_guard<std::mutex> lock(shared);
+                        if (freeBuffers.empty()) {
+                            break;
+                        }
+                        b = freeBuffers.back();
+                        freeBuffers.pop_back();
+                    }
+                    
+                    auto [f, block] = pending.front();
+                    pending.pop_front();
+                    
+                    if (block == 0) {
+                        FileState& file = state[f];
+                        file.fd = open(files[f].c_str(), O_RDONLY);
+                        struct stat info;
+                        if (file.fd < 0 || fstat(file.fd, &info) != 0) {
+                            throw std::runtime_error("Cannot open file: " + files[f]);
+                        }
+                        results[f].bytes = static_cast<std::uint64_t>(info.st_size);
+                        file.blocks = (results[f].bytes + blockBytes - 1) / blockBytes;
+                        file.readsLeft = file.blocks;
+                        
+                        if (file.blocks == 0) {
+                            close(file.fd);
+                            file.fd = -1;
+                            std::lock_guard<std::mutex> lock(shared);
+                            freeBuffers.push_back(b);
+                            continue;
+                        }
+                        if (!options_.detectEncoding) {
+                            scheduleRest(f);
+                        } else if (file.blocks > 1) {
+                            awaitingDetection++;
+                        }
+                    }
+                    
+                    size_t offset = block * blockBytes;
+                    BufferState& buffer = buffers[b];
+                    buffer.file = f;
+                    buffer.block = block;
+                    buffer.length = std::min<size_t>(blockBytes, results[f].bytes - offset);
+                    buffer.readLength = buffer.length + (offset + buffer.length < results[f].bytes);
+                    buffer.filled = 0;
+                    issue(b);
+                    inFlight++;
+                }
+                queue->submit();
+                
+                if (inFlight == 0) {
+                    if (awaitingDetection == 0 && (pending.empty() || !error.empty())) {
+                        break;
+                    }
+                    // Все буферы у задач подсчета или ждем кодировку
+                    #pragma omp taskwait
+                    continue;
+                }
+                
+                ReadCompletion done = queue->wait();
+                inFlight--;
+                BufferState& buffer = buffers[done.buffer];
+                
+                if (done.result < 0) {
+                    errno = static_cast<int>(-done.result);
+                    throw std::runtime_error(systemError("Cannot read file " + files[buffer.file]));
+                }
+                
+                // Короткое чтение дочитывается; конец файла раньше ожидаемого -
+                // файл укоротили во время чтения
+                buffer.filled += static_cast<size_t>(done.result);
+                if (done.result > 0 && buffer.filled < buffer.readLength) {
+                    issue(done.buffer);
+                    inFlight++;
+                    continue;
+                }
+                buffer.length = std::min(buffer.length, buffer.filled);
+                buffer.readLength = buffer.filled;
+                
+                FileState& file = state[buffer.file];
+                if (--file.readsLeft == 0) {
+                    close(file.fd);
+                    file.fd = -1;
+                }
+                
+                unsigned b = done.buffer;
+                BufferState block = buffer;
+                const char* data = storage.data() + b * bufferBytes;
+                bool detect = options_.detectEncoding && block.block == 0;
+                
+                #pragma omp task firstprivate(b, block, data, detect)
+                {
+                    CorpusFileCount& result = results[block.file];
+                    if (detect) {
+                        result.encoding = TextDecoder::detect(std::string(data, block.length));
+                    }
+                    
+                    BookAnalyzer::LetterHistogram letters{};
+                    // В UTF-8 блок прочитан с байтом перекрытия
+                    TextDecoder::accumulate(data, block.length, block.readLength,
+                                            result.encoding, letters);
+                    
+                    std::lock_guard<std::mutex> lock(shared);
+                    for (int a = 0; a < BookAnalyzer::ALPHABET_SIZE; ++a) {
+                        result.letters[a] += letters[a];
+                    }
+                    freeBuffers.push_back(b);
+                    if (detect && state[block.file].blocks > 1) {
+                        detected.push_back(block.file);
+                    }
+                }
+            } catch (const std::exception& e) {
+                // Новые чтения не ставятся, уже отправленные дожидаются:
+                // ядро пишет в буферы, пока они не завершены
+                if (error.empty()) {
+                    error = e.what();
+                }
+                pending.clear();
+                try {
+                    while (inFlight > 0) {
+                        queue->wait();
+                        inFlight--;
+                    }
+                } catch (const std::exception&) {
+                    inFlight = 0;
+                }
+                
+                // Задачи определения кодировки еще могут дописать файл в
+                // detected: после них счетчик сбрасывается вместе со списком
+                #pragma omp taskwait
+                {
+                    std::lock_guard<std::mutex> lock(shared);
+                    detected.clear();
+                }
+                awaitingDetection = 0;
+            }
+        }
+    }
+    
+    for (auto& file : state) {
+        if (file.fd >= 0) {
+            close(file.fd);
+        }
+    }
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+    return results;
+}
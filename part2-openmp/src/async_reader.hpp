@@ -0,0 +1,59 @@
+#ifndef ASYNC_READER_HPP
+#define ASYNC_READER_HPP
+
+#include "book_analyzer.hpp"
+#include "text_encoding.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ReaderBackend {
+    Auto,           // io_uring, если ядро его поддерживает, иначе пул потоков
+    IoUring,
+    ThreadPool
+};
+
+struct AsyncReaderOptions {
+    ReaderBackend backend = ReaderBackend::Auto;
+    unsigned queueDepth = 32;       // Буферов и одновременных чтений
+    size_t blockBytes = 1 << 20;
+    int ioThreads = 4;              // Потоки чтения пула
+    int threads = 0;                // Потоки подсчета (0 - omp_get_max_threads())
+    bool detectEncoding = true;
+    TextEncoding encoding = TextEncoding::UTF8;     // Если detectEncoding == false
+};
+
+// Буквы одного файла корпуса
+struct CorpusFileCount {
+    std::string path;
+    TextEncoding encoding = TextEncoding::UTF8;
+    BookAnalyzer::LetterHistogram letters{};
+    std::uint64_t bytes = 0;
+};
+
+// Чтение корпуса блоками с очередью незавершенных чтений: блоки читаются
+// в заранее выделенные буферы (для io_uring - зарегистрированные в ядре),
+// готовый блок считается OpenMP-задачей, после чего буфер снова идет
+// под чтение. Кодировка файла определяется по первому блоку, остальные
+// его блоки ставятся в очередь после этого, а пока очередь заполняют
+// первые блоки других файлов
+class AsyncCorpusReader {
+public:
+    explicit AsyncCorpusReader(const AsyncReaderOptions& options = AsyncReaderOptions());
+    
+    // Гистограммы в порядке списка файлов
+    std::vector<CorpusFileCount> count(const std::vector<std::string>& files);
+    
+    // Способ чтения (Auto разрешается в конструкторе)
+    ReaderBackend backend() const { return backend_; }
+    
+    static bool ioUringAvailable();
+    static std::string backendName(ReaderBackend backend);
+    static ReaderBackend parseBackend(const std::string& name);
+    
+private:
+    AsyncReaderOptions options_;
+    ReaderBackend backend_;
+};
+
+#endif // ASYNC_READER_HPP
@@ -0,0 +1,156 @@
+#include "auto_tuner.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <omp.h>
+
+namespace {
+
+BookAnalyzer::ScheduleKind parseSchedule(const std::string& name) {
+    if (name == "static") return BookAnalyzer::ScheduleKind::Static;
+    if (name == "guided") return BookAnalyzer::ScheduleKind::Guided;
+    if (name == "dynamic") return BookAnalyzer::ScheduleKind::Dynamic;
+    throw std::runtime_error("Unknown schedule in tuning profile: " + name);
+}
+
+} // namespace
+
+AutoTuner::AutoTuner(const std::string& profilePath)
+    : profilePath_(profilePath) {
+    load();
+}
+
+int AutoTuner::sizeClass(size_t bytes) {
+    int cls = 0;
+    while (bytes > 1) {
+        bytes >>= 1;
+        cls++;
+    }
+    return cls;
+}
+
+std::vector<AutoTuner::Measurement> AutoTuner::benchmark(const std::string& text) const {
+    // Короткий вход замеряется целиком, длинный - по префиксу
+    std::string prefix = text.substr(0, std::min(text.size(), prefixBytes));
+    
+    // Потоки: степени двойки до числа ядер и само число ядер
+    int maxThreads = omp_get_max_threads();
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+    
+    const BookAnalyzer::ScheduleKind schedules[] = {
+        BookAnalyzer::ScheduleKind::Static,
+        BookAnalyzer::ScheduleKind::Dynamic,
+        BookAnalyzer::ScheduleKind::Guided
+    };
+    const int chunks[] = {1024, 4096, 16384, 65536};
+    
+    BookAnalyzer analyzer;
+    std::vector<Measurement> results;
+    
+    for (int threads : threadCounts) {
+        for (auto schedule : schedules) {
+            for (int chunk : chunks) {
+                Measurement m;
+                m.config = {threads, schedule, chunk};
+                m.microseconds = -1.0;
+                
+                for (int rep = 0; rep < repetitions; ++rep) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    analyzer.analyzeTextWith(prefix, m.config);
+                    double us = std::chrono::duration<double, std::micro>(
+                        std::chrono::high_resolution_clock::now() - start).count();
+                    if (m.microseconds < 0.0 || us < m.microseconds) {
+                        m.microseconds = us;
+                    }
+                }
+                results.push_back(m);
+            }
+        }
+    }
+    
+    std::stable_sort(results.begin(), results.end(),
+                     [](const auto& a, const auto& b) { return a.microseconds < b.microseconds; });
+    return results;
+}
+
+BookAnalyzer::TuningConfig AutoTuner::choose(const std::string& text, std::string* source) {
+    int cls = sizeClass(text.size());
+    
+    auto cached = cache_.find(cls);
+    if (cached != cache_.end()) {
+        if (source) *source = "cache";
+        return cached->second.config;
+    }
+    
+    // Запись профиля с большим числом потоков, чем доступно сейчас,
+    // сделана на другой машине и не используется
+    auto stored = profile_.find(cls);
+    if (stored != profile_.end() && stored->second.config.threads <= omp_get_max_threads()) {
+        cache_[cls] = stored->second;
+        if (source) *source = "profile";
+        return stored->second.config;
+    }
+    
+    Measurement best = benchmark(text).front();
+    cache_[cls] = best;
+    if (source) *source = "benchmark";
+    return best.config;
+}
+
+void AutoTuner::load() {
+    if (profilePath_.empty()) {
+        return;
+    }
+    
+    std::ifstream file(profilePath_);
+    if (!file.is_open()) {
+        return;  // Профиля еще нет
+    }
+    
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        std::istringstream fields(line);
+        int cls;
+        Measurement m;
+        std::string schedule;
+        if (!(fields >> cls >> m.config.threads >> schedule >> m.config.chunk >> m.microseconds)) {
+            throw std::runtime_error("Invalid tuning profile line: " + line);
+        }
+        m.config.schedule = parseSchedule(schedule);
+        profile_[cls] = m;
+    }
+}
+
+void AutoTuner::save() const {
+    if (profilePath_.empty()) {
+        return;
+    }
+    
+    // Новые решения дополняют ранее сохраненные
+    std::map<int, Measurement> merged = profile_;
+    for (const auto& entry : cache_) {
+        merged[entry.first] = entry.second;
+    }
+    
+    std::ofstream file(profilePath_);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + profilePath_);
+    }
+    
+    file << "# size_class threads schedule chunk prefix_time_us\n";
+    for (const auto& entry : merged) {
+        const auto& config = entry.second.config;
+        file << entry.first << " " << config.threads << " "
+             << BookAnalyzer::scheduleName(config.schedule) << " "
+             << config.chunk << " " << entry.second.microseconds << "\n";
+    }
+}
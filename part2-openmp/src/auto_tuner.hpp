@@ -0,0 +1,48 @@
+#ifndef AUTO_TUNER_HPP
+#define AUTO_TUNER_HPP
+
+#include "book_analyzer.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+// Подбор числа потоков, расписания и размера порции для analyzeTextWith.
+// Решение зависит от класса размера входа (степень двойки длины):
+// сначала ищется в кеше, затем в сохраненном профиле машины, иначе
+// кандидаты замеряются на префиксе текста и лучший запоминается
+class AutoTuner {
+public:
+    struct Measurement {
+        BookAnalyzer::TuningConfig config;
+        double microseconds = 0.0;   // Лучшее время на префиксе
+    };
+    
+    // Пустой путь - профиль не читается и не сохраняется
+    explicit AutoTuner(const std::string& profilePath = "");
+    
+    // Конфигурация для текста; source - откуда взято решение
+    // (cache, profile или benchmark)
+    BookAnalyzer::TuningConfig choose(const std::string& text, std::string* source = nullptr);
+    
+    // Замер всех кандидатов на префиксе, результаты по возрастанию времени
+    std::vector<Measurement> benchmark(const std::string& text) const;
+    
+    // Запись кеша в профиль (формат: класс потоки расписание порция время)
+    void save() const;
+    
+    static int sizeClass(size_t bytes);
+    const std::map<int, Measurement>& cache() const { return cache_; }
+    
+    // Длина префикса для замеров и число повторов каждого кандидата
+    size_t prefixBytes = 1 << 20;
+    int repetitions = 3;
+    
+private:
+    void load();
+    
+    std::string profilePath_;
+    std::map<int, Measurement> cache_;
+    std::map<int, Measurement> profile_;
+};
+
+#endif // AUTO_TUNER_HPP
@@ -1,5 +1,10 @@
 #include "book_analyzer.hpp"
+#include "text_encoding.hpp"
+#include "letter_kernel.hpp"
 #include <unordered_map>
+#include <cstdint>
+#include <stdexcept>
+#include <cctype>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
@@ -13,86 +18,171 @@
 
 BookAnalyzer::BookAnalyzer() {}
 
-// Проверка является ли символ русской буквой в UTF-8
-bool BookAnalyzer::isRussianLetterUTF8(const unsigned char* bytes, size_t& pos, size_t length) {
-    if (pos >= length) return false;
-    
-    unsigned char c1 = bytes[pos];
-    
-    // Русские буквы в UTF-8
-    if (c1 == 0xD0) {  // Первая часть двухбайтовой последовательности
-        if (pos + 1 >= length) return false;
-        unsigned char c2 = bytes[pos + 1];
+namespace {
+
+using SlotTotals = LetterKernel::Totals;
+using CountFunction = SlotTotals (*)(const unsigned char*, size_t, int, size_t);
+
+// Параллельный подсчет одной специализацией ядра: потоки берут блоки
+// по blockBytes байтов с расписанием, заданным omp_set_schedule
+template <class Alphabet, class CaseMode, typename Counter>
+SlotTotals countLetters(const unsigned char* data, size_t length, int threads, size_t blockBytes) {
+    size_t blocks = (length + blockBytes - 1) / blockBytes;
+    SlotTotals totals{};
+    
+    #pragma omp parallel num_threads(threads)
+    {
+        // Счетчики на стеке потока - без ложного разделения кеш-линий.
+        // Узкие счетчики сбрасываются в 64-битные до возможного переполнения
+        LetterKernel::Counters<Counter> counters{};
+        SlotTotals local{};
+        std::uint64_t pending = 0;
         
-        // А-Я (кроме Ё), а-п
-        if ((c2 >= 0x90 && c2 <= 0x9F) ||  // А-П (заглавные)
-            (c2 >= 0xA0 && c2 <= 0xAF) ||  // Р-Я (заглавные)
-            (c2 >= 0xB0 && c2 <= 0xBF)) {  // а-п (строчные)
-            pos += 2;  // Сдвигаем позицию на 2 байта
-            return true;
+        #pragma omp for schedule(runtime) nowait
+        for (size_t b = 0; b < blocks; ++b) {
+            size_t from = b * blockBytes;
+            size_t to = std::min(length, from + blockBytes);
+            if (pending + (to - from) > LetterKernel::flushBytes<Counter>()) {
+                LetterKernel::flush(counters, local);
+                pending = 0;
+            }
+            LetterKernel::count<Alphabet, CaseMode, Counter>(data, from, to, length, counters);
+            pending += to - from;
         }
-    } 
-    else if (c1 == 0xD1) {  // Вторая часть русского алфавита
-        if (pos + 1 >= length) return false;
-        unsigned char c2 = bytes[pos + 1];
+        LetterKernel::flush(counters, local);
         
-        // р-я, ё
-        if ((c2 >= 0x80 && c2 <= 0x8F) ||  // р-я (строчные)
-            c2 == 0x91) {                   // ё (строчная)
-            pos += 2;
-            return true;
-        }
-    }
-    else if (c1 == 0xD0 && pos + 1 < length) {  // Ё заглавная
-        if (bytes[pos + 1] == 0x81) {
-            pos += 2;
-            return true;
+        #pragma omp critical
+        for (int s = 0; s < LetterKernel::SLOTS; ++s) {
+            totals[s] += local[s];
         }
     }
     
-    return false;
+    return totals;
+}
+
+template <class Alphabet, class CaseMode>
+CountFunction selectWidth(bool narrow) {
+    return narrow ? &countLetters<Alphabet, CaseMode, std::uint32_t>
+                  : &countLetters<Alphabet, CaseMode, std::uint64_t>;
+}
+
+template <class Alphabet>
+CountFunction selectCase(bool foldCase, bool narrow) {
+    return foldCase ? selectWidth<Alphabet, LetterKernel::FoldCase>(narrow)
+                    : selectWidth<Alphabet, LetterKernel::KeepCase>(narrow);
+}
+
+CountFunction selectKernel(const BookAnalyzer::CountingOptions& options) {
+    bool narrow = options.counters != BookAnalyzer::CounterWidth::Wide;
+    return options.alphabet == BookAnalyzer::Alphabet::RussianYoAsYe
+               ? selectCase<LetterKernel::RussianYoAsYe>(options.foldCase, narrow)
+               : selectCase<LetterKernel::Russian>(options.foldCase, narrow);
 }
 
-// Получение русской буквы из UTF-8
-std::string BookAnalyzer::getRussianLetterUTF8(const unsigned char* bytes, size_t pos) {
-    std::string letter;
-    if (pos + 1 < std::string::npos) {
-        letter += static_cast<char>(bytes[pos]);
-        letter += static_cast<char>(bytes[pos + 1]);
+// Подсчет выбранной специализацией с параметрами распараллеливания
+SlotTotals runKernel(const unsigned char* data, size_t length,
+                     const BookAnalyzer::TuningConfig& config,
+                     const BookAnalyzer::CountingOptions& options) {
+    int threads = config.threads > 0 ? config.threads : omp_get_max_threads();
+    
+    // Расписание цикла задается во время выполнения (schedule(runtime)).
+    // Порция - блок из chunk байтов, блоки раздаются по одному.
+    // Прежнее расписание вызывающего потока восстанавливается: от него
+    // зависят циклы schedule(runtime) программы, загрузившей библиотеку
+    omp_sched_t kind = config.schedule == BookAnalyzer::ScheduleKind::Static ? omp_sched_static :
+                       config.schedule == BookAnalyzer::ScheduleKind::Guided ? omp_sched_guided :
+                       omp_sched_dynamic;
+    omp_sched_t savedKind;
+    int savedChunk;
+    omp_get_schedule(&savedKind, &savedChunk);
+    omp_set_schedule(kind, 1);
+    
+    size_t blockBytes = static_cast<size_t>(std::max(1, config.chunk));
+    SlotTotals totals = selectKernel(options)(data, length, threads, blockBytes);
+    omp_set_schedule(savedKind, savedChunk);
+    return totals;
+}
+
+// Заглавная буква UTF-8 по индексу алфавита
+std::string upperLetterFromIndex(int index) {
+    if (index == 6) {
+        return std::string({static_cast<char>(0xD0), static_cast<char>(0x81)});
+    }
+    if (index < 17) {
+        int k = index < 6 ? index : index - 1;
+        return std::string({static_cast<char>(0xD0), static_cast<char>(0x90 + k)});
     }
-    return letter;
+    return std::string({static_cast<char>(0xD0), static_cast<char>(0xA0 + index - 17)});
 }
 
-// Приведение русской буквы к нижнему регистру
-std::string BookAnalyzer::toLowerRussianUTF8(const std::string& letter) {
-    if (letter.length() != 2) return letter;
+} // namespace
+
+// Индекс буквы в алфавите: заглавные и строчные отображаются в один индекс
+int BookAnalyzer::letterIndexUTF8(const unsigned char* bytes, size_t pos, size_t length) {
+    if (pos + 1 >= length) return -1;
+    
+    unsigned char c1 = bytes[pos];
+    unsigned char c2 = bytes[pos + 1];
+    
+    if (c1 == 0xD0) {
+        if (c2 == 0x81) return 6;  // Ё
+        if (c2 >= 0x90 && c2 <= 0xBF) {
+            // А-Я (0x90-0xAF) и а-п (0xB0-0xBF): номер буквы без Ё
+            int k = (c2 - 0x90) % 32;
+            return k < 6 ? k : k + 1;
+        }
+    } else if (c1 == 0xD1) {
+        if (c2 == 0x91) return 6;  // ё
+        if (c2 >= 0x80 && c2 <= 0x8F) return 17 + (c2 - 0x80);  // р-я
+    }
     
-    unsigned char c1 = static_cast<unsigned char>(letter[0]);
-    unsigned char c2 = static_cast<unsigned char>(letter[1]);
+    return -1;
+}
+
+std::string BookAnalyzer::letterFromIndex(int index) {
+    if (index < 0 || index >= ALPHABET_SIZE) return "";
     
-    // Заглавные А-П (0xD0 0x90-0x9F) -> строчные а-п (0xD0 0xB0-0xBF)
-    if (c1 == 0xD0 && c2 >= 0x90 && c2 <= 0x9F) {
-        return std::string({static_cast<char>(c1), static_cast<char>(c2 + 0x20)});
+    if (index == 6) {
+        return std::string({static_cast<char>(0xD1), static_cast<char>(0x91)});
     }
-    // Заглавные Р-Я (0xD0 0xA0-0xAF) -> строчные р-я (0xD1 0x80-0x8F)
-    else if (c1 == 0xD0 && c2 >= 0xA0 && c2 <= 0xAF) {
-        unsigned char new_c1 = 0xD1;
-        unsigned char new_c2 = c2 - 0x20;
-        return std::string({static_cast<char>(new_c1), static_cast<char>(new_c2)});
+    if (index < 17) {
+        int k = index < 6 ? index : index - 1;
+        return std::string({static_cast<char>(0xD0), static_cast<char>(0xB0 + k)});
     }
-    // Заглавная Ё (0xD0 0x81) -> строчная ё (0xD1 0x91)
-    else if (c1 == 0xD0 && c2 == 0x81) {
-        return std::string({static_cast<char>(0xD1), static_cast<char>(0x91)});
+    return std::string({static_cast<char>(0xD1), static_cast<char>(0x80 + index - 17)});
+}
+
+BookAnalyzer::AnalysisResult BookAnalyzer::resultFromHistogram(
+    const LetterHistogram& histogram,
+    std::uint64_t totalCharacters) {
+    
+    std::map<std::string, std::uint64_t> freq;
+    std::uint64_t total = 0;
+    for (int i = 0; i < ALPHABET_SIZE; ++i) {
+        if (histogram[i] > 0) {
+            freq[letterFromIndex(i)] = histogram[i];
+            total += histogram[i];
+        }
     }
     
-    return letter;  // Уже строчная или не требует преобразования
+    return AnalysisResult{
+        freq,
+        sortByFrequency(freq),
+        std::chrono::microseconds(0),
+        1,
+        total,
+        totalCharacters,
+        1.0,
+        {},
+        {}
+    };
 }
 
 // Сортировка по частоте
-std::vector<std::pair<std::string, int>> BookAnalyzer::sortByFrequency(
-    const std::map<std::string, int>& freq) {
+std::vector<std::pair<std::string, std::uint64_t>> BookAnalyzer::sortByFrequency(
+    const std::map<std::string, std::uint64_t>& freq) {
     
-    std::vector<std::pair<std::string, int>> sorted;
+    std::vector<std::pair<std::string, std::uint64_t>> sorted;
     sorted.reserve(freq.size());
     
     for (const auto& pair : freq) {
@@ -110,50 +200,28 @@ std::vector<std::pair<std::string, int>> BookAnalyzer::sortByFrequency(
 // Основная функция анализа с OpenMP
 BookAnalyzer::AnalysisResult BookAnalyzer::analyzeTextImpl(
     const std::string& text, 
-    int threads) {
+    const TuningConfig& config,
+    const CountingOptions& options) {
     
     auto startTime = std::chrono::high_resolution_clock::now();
     
-    if (threads <= 0) {
-        threads = omp_get_max_threads();
-    }
+    int threads = config.threads > 0 ? config.threads : omp_get_max_threads();
     
     const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
     size_t length = text.length();
+    SlotTotals totals = runKernel(data, length, config, options);
     
-    // Локальные частоты для каждого потока
-    std::vector<std::unordered_map<std::string, int>> localFreq(threads);
-    int totalLetters = 0;
-    
-    omp_set_num_threads(threads);
-    
-    #pragma omp parallel reduction(+:totalLetters)
-    {
-        int threadId = omp_get_thread_num();
-        auto& threadMap = localFreq[threadId];
-        
-        #pragma omp for schedule(dynamic, 4096)
-        for (size_t i = 0; i < length; i++) {
-            size_t pos = i;
-            if (isRussianLetterUTF8(data, pos, length)) {
-                std::string letter = getRussianLetterUTF8(data, i);
-                std::string lowerLetter = toLowerRussianUTF8(letter);
-                
-                threadMap[lowerLetter]++;
-                totalLetters++;
-                
-                // Пропускаем второй байт UTF-8
-                i++;  // Увеличиваем i, так как русская буква занимает 2 байта
-            }
-        }
-    }
-    
-    // Объединяем результаты
-    std::map<std::string, int> globalFreq;
-    for (int t = 0; t < threads; ++t) {
-        for (const auto& pair : localFreq[t]) {
-            globalFreq[pair.first] += pair.second;
+    std::map<std::string, std::uint64_t> globalFreq;
+    std::uint64_t totalLetters = 0;
+    for (int s = 0; s < LetterKernel::SINK; ++s) {
+        if (totals[s] == 0) {
+            continue;
         }
+        int index = s % LetterKernel::LOWER_SLOTS;
+        std::string letter = s < LetterKernel::LOWER_SLOTS ? letterFromIndex(index)
+                                                           : upperLetterFromIndex(index);
+        globalFreq[letter] = totals[s];
+        totalLetters += totals[s];
     }
     
     auto endTime = std::chrono::high_resolution_clock::now();
@@ -167,13 +235,51 @@ BookAnalyzer::AnalysisResult BookAnalyzer::analyzeTextImpl(
         duration,
         threads,
         totalLetters,
-        static_cast<int>(length),
+        length,
         1.0,
         {},
         {}
     };
 }
 
+BookAnalyzer::LetterStream::LetterStream(int threads)
+    : threads_(threads > 0 ? threads : omp_get_max_threads()) {}
+
+void BookAnalyzer::LetterStream::add(const char* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    
+    // Буква, начатая в конце предыдущей части: ее второй байт - продолжение,
+    // которое в этой части букву не начинает
+    if (carry_ != 0) {
+        const unsigned char pair[2] = {carry_, bytes[0]};
+        LetterKernel::Counters<std::uint64_t> joined{};
+        LetterKernel::count<LetterKernel::Russian, LetterKernel::FoldCase>(pair, 0, 1, 2, joined);
+        for (int a = 0; a < ALPHABET_SIZE; ++a) {
+            histogram_[a] += joined[a];
+        }
+        carry_ = 0;
+    }
+    
+    // Ядро не начинает букву в последнем байте - он переносится
+    SlotTotals totals = runKernel(bytes, length, TuningConfig{threads_}, CountingOptions());
+    for (int a = 0; a < ALPHABET_SIZE; ++a) {
+        histogram_[a] += totals[a];
+    }
+    if ((bytes[length - 1] & 0xFE) == 0xD0) {
+        carry_ = bytes[length - 1];
+    }
+    characters_ += length;
+}
+
+BookAnalyzer::AnalysisResult BookAnalyzer::LetterStream::result() const {
+    AnalysisResult result = resultFromHistogram(histogram_, characters_);
+    result.threadsUsed = threads_;
+    return result;
+}
+
 // Чтение файла в строку
 std::string BookAnalyzer::readFileToString(const std::string& filename) {
     std::ifstream file(filename, std::ios::binary | std::ios::ate);
@@ -198,7 +304,13 @@ BookAnalyzer::AnalysisResult BookAnalyzer::analyzeFile(
     int threads) {
     
     std::string text = readFileToString(filename);
-    return analyzeTextImpl(text, threads);
+    
+    // Файлы в CP1251 и KOI8-R считаются табличным однобайтовым путем
+    TextEncoding encoding = TextDecoder::detect(text);
+    if (encoding != TextEncoding::UTF8) {
+        return TextDecoder::analyze(text, encoding, threads);
+    }
+    return analyzeTextImpl(text, TuningConfig{threads}, CountingOptions());
 }
 
 // Анализ текста
@@ -206,7 +318,255 @@ BookAnalyzer::AnalysisResult BookAnalyzer::analyzeText(
     const std::string& text, 
     int threads) {
     
-    return analyzeTextImpl(text, threads);
+    return analyzeTextImpl(text, TuningConfig{threads}, CountingOptions());
+}
+
+BookAnalyzer::AnalysisResult BookAnalyzer::analyzeTextWith(
+    const std::string& text,
+    const TuningConfig& config) {
+    
+    return analyzeTextImpl(text, config, CountingOptions());
+}
+
+BookAnalyzer::AnalysisResult BookAnalyzer::analyzeTextWith(
+    const std::string& text,
+    const TuningConfig& config,
+    const CountingOptions& options) {
+    
+    return analyzeTextImpl(text, config, options);
+}
+
+BookAnalyzer::LetterHistogram BookAnalyzer::countLetters(
+    const char* data,
+    size_t length,
+    const TuningConfig& config) {
+    
+    SlotTotals totals = runKernel(reinterpret_cast<const unsigned char*>(data), length,
+                                  config, CountingOptions());
+    LetterHistogram histogram{};
+    std::copy(totals.begin(), totals.begin() + ALPHABET_SIZE, histogram.begin());
+    return histogram;
+}
+
+std::string BookAnalyzer::scheduleName(ScheduleKind kind) {
+    switch (kind) {
+        case ScheduleKind::Static:
+            return "static";
+        case ScheduleKind::Guided:
+            return "guided";
+        default:
+            return "dynamic";
+    }
+}
+
+double BookAnalyzer::TextStatistics::averageWordLength() const {
+    std::uint64_t characters = 0;
+    for (size_t length = 0; length < wordLengths.size(); ++length) {
+        characters += length * wordLengths[length];
+    }
+    return words > 0 ? static_cast<double>(characters) / words : 0.0;
+}
+
+void BookAnalyzer::TextStatistics::add(const TextStatistics& other) {
+    for (int a = 0; a < ALPHABET_SIZE; ++a) {
+        letters[a] += other.letters[a];
+    }
+    totalLetters += other.totalLetters;
+    words += other.words;
+    sentences += other.sentences;
+    totalCharacters += other.totalCharacters;
+    
+    if (wordLengths.size() < other.wordLengths.size()) {
+        wordLengths.resize(other.wordLengths.size(), 0);
+    }
+    for (size_t l = 0; l < other.wordLengths.size(); ++l) {
+        wordLengths[l] += other.wordLengths[l];
+    }
+}
+
+void BookAnalyzer::TextStatistics::subtract(const TextStatistics& other) {
+    // Вычитается только то, что было прибавлено раньше
+    for (int a = 0; a < ALPHABET_SIZE; ++a) {
+        letters[a] -= other.letters[a];
+    }
+    totalLetters -= other.totalLetters;
+    words -= other.words;
+    sentences -= other.sentences;
+    totalCharacters -= other.totalCharacters;
+    
+    for (size_t l = 0; l < other.wordLengths.size() && l < wordLengths.size(); ++l) {
+        wordLengths[l] -= other.wordLengths[l];
+    }
+}
+
+namespace {
+
+// Итог обработки одного участка текста. Слова и предложения, разрезанные
+// границей участка, досчитываются при последовательном слиянии
+struct ChunkSummary {
+    BookAnalyzer::LetterHistogram letters{};
+    std::vector<std::uint64_t> wordLengths;
+    std::uint64_t words = 0;          // Слова целиком внутри участка
+    std::uint64_t sentences = 0;      // Предложения, закрытые после слова из участка
+    std::uint64_t leadingWord = 0;    // Длина слова от начала участка
+    std::uint64_t trailingWord = 0;   // Длина слова до конца участка
+    bool allWord = true;              // Участок - часть одного слова
+    bool terminatorBeforeWord = false;  // Знак конца раньше первого слова
+    bool hasContent = false;          // Есть слово или знак конца
+    bool openSentence = false;        // После последнего знака было слово
+};
+
+void addWordLength(std::vector<std::uint64_t>& lengths, std::uint64_t length) {
+    lengths[std::min<std::uint64_t>(length, BookAnalyzer::MAX_WORD_LENGTH)]++;
+}
+
+} // namespace
+
+// Один проход по памяти: каждый поток классифицирует символы своего
+// участка, граничные слова и предложения сшиваются при слиянии
+BookAnalyzer::TextStatistics BookAnalyzer::analyzeStatistics(
+    const std::string& text,
+    int threads) {
+    
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    size_t length = text.length();
+    
+    // Участки по 256 КиБ (не меньше одного на поток) с началом на границе
+    // символа UTF-8, чтобы буквы не разрезались
+    size_t chunks = std::max<size_t>(threads, length / (256 * 1024));
+    std::vector<size_t> bounds(chunks + 1, length);
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t pos = length * c / chunks;
+        while (pos < length && (data[pos] & 0xC0) == 0x80) {
+            pos++;
+        }
+        bounds[c] = pos;
+    }
+    
+    std::vector<ChunkSummary> summaries(chunks);
+    
+    #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+    for (size_t c = 0; c < chunks; ++c) {
+        ChunkSummary& s = summaries[c];
+        s.wordLengths.assign(MAX_WORD_LENGTH + 1, 0);
+        
+        size_t end = std::max(bounds[c], bounds[c + 1]);
+        std::uint64_t word = 0;        // Длина текущего слова
+        bool atStart = true;           // Текущее слово начато с начала участка
+        
+        for (size_t i = bounds[c]; i < end; ) {
+            int letter = letterIndexUTF8(data, i, length);
+            unsigned char ch = data[i];
+            bool wordChar = letter >= 0 || std::isalnum(ch);
+            
+            if (wordChar) {
+                if (letter >= 0) {
+                    s.letters[letter]++;
+                    i += 2;
+                } else {
+                    i++;
+                }
+                word++;
+                s.hasContent = true;
+                s.openSentence = true;
+                continue;
+            }
+            
+            // Разделитель закрывает текущее слово
+            if (word > 0) {
+                if (atStart) {
+                    s.leadingWord = word;
+                } else {
+                    addWordLength(s.wordLengths, word);
+                    s.words++;
+                }
+                word = 0;
+            }
+            atStart = false;
+            s.allWord = false;
+            
+            if (ch == '.' || ch == '!' || ch == '?') {
+                if (!s.hasContent) {
+                    s.terminatorBeforeWord = true;
+                } else if (s.openSentence) {
+                    s.sentences++;
+                }
+                s.hasContent = true;
+                s.openSentence = false;
+            }
+            i++;
+        }
+        
+        if (word > 0) {
+            if (atStart) {
+                s.leadingWord = word;
+            } else {
+                s.trailingWord = word;
+            }
+        }
+    }
+    
+    // Последовательное слияние в порядке участков
+    TextStatistics stats;
+    stats.wordLengths.assign(MAX_WORD_LENGTH + 1, 0);
+    std::uint64_t carryWord = 0;       // Слово, продолжающееся через границу
+    bool openSentence = false;
+    
+    for (const auto& s : summaries) {
+        for (int a = 0; a < ALPHABET_SIZE; ++a) {
+            stats.letters[a] += s.letters[a];
+        }
+        for (int l = 0; l <= MAX_WORD_LENGTH; ++l) {
+            stats.wordLengths[l] += s.wordLengths[l];
+        }
+        stats.words += s.words;
+        stats.sentences += s.sentences;
+        
+        if (s.allWord) {
+            carryWord += s.leadingWord;
+        } else {
+            carryWord += s.leadingWord;
+            if (carryWord > 0) {
+                addWordLength(stats.wordLengths, carryWord);
+                stats.words++;
+            }
+            carryWord = s.trailingWord;
+        }
+        
+        // Первый знак конца участка закрывает предложение, открытое раньше
+        if (s.terminatorBeforeWord && openSentence) {
+            stats.sentences++;
+        }
+        if (s.hasContent) {
+            openSentence = s.openSentence;
+        }
+    }
+    
+    if (carryWord > 0) {
+        addWordLength(stats.wordLengths, carryWord);
+        stats.words++;
+    }
+    // Последнее предложение без знака конца тоже считается
+    if (openSentence) {
+        stats.sentences++;
+    }
+    
+    for (int a = 0; a < ALPHABET_SIZE; ++a) {
+        stats.totalLetters += stats.letters[a];
+    }
+    
+    stats.threadsUsed = threads;
+    stats.totalCharacters = length;
+    stats.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime
+    );
+    return stats;
 }
 
 // Бенчмарк с разным количеством потоков
@@ -225,12 +585,14 @@ std::vector<BookAnalyzer::AnalysisResult> BookAnalyzer::benchmarkThreads(
     
     try {
         std::string text = readFileToString(filename);
+        TextEncoding encoding = TextDecoder::detect(text);
         
         for (int threads : threadConfigs) {
             std::cout << "\nRunning with " << threads << " thread(s)..." << std::endl;
             
             auto start = std::chrono::high_resolution_clock::now();
-            auto result = analyzeText(text, threads);
+            auto result = encoding == TextEncoding::UTF8 ?
+                analyzeText(text, threads) : TextDecoder::analyze(text, encoding, threads);
             auto end = std::chrono::high_resolution_clock::now();
             
             auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
@@ -306,7 +668,7 @@ void BookAnalyzer::saveFrequencyCSV(const AnalysisResult& result, const std::str
     
     file << "letter,utf8_code,frequency,percentage\n";
     
-    int total = result.totalLetters;
+    std::uint64_t total = result.totalLetters;
     for (const auto& pair : result.sortedLetters) {
         double percentage = (pair.second * 100.0) / total;
         
@@ -728,6 +1090,58 @@ void BookAnalyzer::printResults(const AnalysisResult& result, int topN) {
     std::cout << "\nTotal unique Russian letters: " << result.sortedLetters.size() << std::endl;
 }
 
+void BookAnalyzer::printStatistics(const TextStatistics& stats) {
+    std::cout << "TEXT STATISTICS (single pass)" << std::endl;
+    
+    std::cout << "\nProcessing Statistics:" << std::endl;
+    std::cout << " Threads used: " << stats.threadsUsed << std::endl;
+    std::cout << " Processing time: " << stats.processingTime.count() / 1000.0 << " ms" << std::endl;
+    std::cout << " Total characters: " << stats.totalCharacters << std::endl;
+    std::cout << " Total Russian letters: " << stats.totalLetters << std::endl;
+    std::cout << " Words: " << stats.words << std::endl;
+    std::cout << " Sentences: " << stats.sentences << std::endl;
+    std::cout << " Average word length: " << std::fixed << std::setprecision(2)
+              << stats.averageWordLength() << std::endl;
+    if (stats.sentences > 0) {
+        std::cout << " Words per sentence: " << std::setprecision(2)
+                  << static_cast<double>(stats.words) / stats.sentences << std::endl;
+    }
+    
+    std::cout << "\nWord Length Distribution:" << std::endl;
+    for (int length = 1; length <= MAX_WORD_LENGTH; ++length) {
+        if (stats.wordLengths[length] == 0) continue;
+        double percentage = stats.wordLengths[length] * 100.0 / stats.words;
+        std::cout << "   " << std::setw(2) << length
+                  << (length == MAX_WORD_LENGTH ? "+" : " ") << ": "
+                  << std::setw(8) << stats.wordLengths[length] << " words ("
+                  << std::setprecision(2) << std::setw(5) << percentage << "%)" << std::endl;
+    }
+}
+
+void BookAnalyzer::saveStatisticsCSV(const TextStatistics& stats, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return;
+    }
+    
+    file << "metric,value\n";
+    file << "characters," << stats.totalCharacters << "\n";
+    file << "letters," << stats.totalLetters << "\n";
+    file << "words," << stats.words << "\n";
+    file << "sentences," << stats.sentences << "\n";
+    file << "average_word_length," << std::fixed << std::setprecision(4)
+         << stats.averageWordLength() << "\n";
+    
+    for (int length = 1; length <= MAX_WORD_LENGTH; ++length) {
+        file << "words_length_" << length << (length == MAX_WORD_LENGTH ? "_plus" : "")
+             << "," << stats.wordLengths[length] << "\n";
+    }
+    
+    file.close();
+    std::cout << "Text statistics saved to: " << filename << std::endl;
+}
+
 // Вывод результатов бенчмарка
 void BookAnalyzer::printBenchmarkResults(const std::vector<AnalysisResult>& results) {
     std::cout << "BENCHMARK RESULTS SUMMARY" << std::endl;
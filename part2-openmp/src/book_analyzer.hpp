@@ -4,29 +4,88 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <array>
 #include <chrono>
+#include <cstdint>
 
 class BookAnalyzer {
 public:
     // Структура для хранения результатов анализа
     struct AnalysisResult {
-        std::map<std::string, int> letterFrequency;
-        std::vector<std::pair<std::string, int>> sortedLetters;
+        std::map<std::string, std::uint64_t> letterFrequency;
+        std::vector<std::pair<std::string, std::uint64_t>> sortedLetters;
         std::chrono::microseconds processingTime;
         int threadsUsed;
-        int totalLetters;
-        int totalCharacters;
+        std::uint64_t totalLetters;
+        std::uint64_t totalCharacters;
         double speedup;
         std::vector<int> threadHistory;
         std::vector<double> speedupHistory;
     };
     
+    // Русский алфавит: индексы строчных букв а-е 0-5, ё 6, ж-я 7-32
+    static constexpr int ALPHABET_SIZE = 33;
+    using LetterHistogram = std::array<std::uint64_t, ALPHABET_SIZE>;
+    
+    // Параметры распараллеливания основного цикла
+    enum class ScheduleKind { Static, Dynamic, Guided };
+    struct TuningConfig {
+        int threads = 0;                          // 0 - omp_get_max_threads()
+        ScheduleKind schedule = ScheduleKind::Dynamic;
+        int chunk = 4096;
+    };
+    static std::string scheduleName(ScheduleKind kind);
+    
+    // Параметры ядра подсчета букв (см. letter_kernel.hpp)
+    enum class Alphabet { Russian, RussianYoAsYe };
+    enum class CounterWidth { Auto, Narrow, Wide };
+    struct CountingOptions {
+        Alphabet alphabet = Alphabet::Russian;
+        bool foldCase = true;                     // false - заглавные отдельно
+        CounterWidth counters = CounterWidth::Auto;  // Auto - 32 бита со сбросом в 64
+    };
+    
+    // Длины слов от 1 до MAX_WORD_LENGTH, последний столбец - длиннее
+    static constexpr int MAX_WORD_LENGTH = 32;
+    
+    // Сводная статистика текста за один проход
+    struct TextStatistics {
+        LetterHistogram letters{};
+        std::uint64_t totalLetters = 0;
+        std::uint64_t words = 0;
+        std::uint64_t sentences = 0;
+        std::vector<std::uint64_t> wordLengths;  // Индекс - длина слова в символах
+        std::chrono::microseconds processingTime{0};
+        int threadsUsed = 0;
+        size_t totalCharacters = 0;
+        
+        double averageWordLength() const;
+        
+        // Сложение и вычитание профилей (агрегат по многим файлам)
+        void add(const TextStatistics& other);
+        void subtract(const TextStatistics& other);
+    };
+    
     BookAnalyzer();
     
     // Основные методы анализа
     AnalysisResult analyzeFile(const std::string& filename, int threads = 0);
     AnalysisResult analyzeText(const std::string& text, int threads = 0);
     
+    // Анализ с явно заданными потоками, расписанием и размером порции
+    AnalysisResult analyzeTextWith(const std::string& text, const TuningConfig& config);
+    AnalysisResult analyzeTextWith(const std::string& text, const TuningConfig& config,
+                                   const CountingOptions& options);
+    
+    // Гистограмма букв UTF-8 текста, переданного указателем (без копирования)
+    static LetterHistogram countLetters(const char* data, size_t length,
+                                        const TuningConfig& config);
+    
+    // Буквы, слова, предложения и распределение длин слов одним проходом.
+    // Слово - непрерывная последовательность русских и латинских букв
+    // и цифр; предложение заканчивается первым из знаков . ! ? после слова
+    TextStatistics analyzeStatistics(const std::string& text, int threads = 0);
+    
     // Бенчмарк и производительность
     std::vector<AnalysisResult> benchmarkThreads(
         const std::string& filename,
@@ -46,6 +105,42 @@ public:
     // Вывод результатов
     static void printResults(const AnalysisResult& result, int topN = 20);
     static void printBenchmarkResults(const std::vector<AnalysisResult>& results);
+    static void printStatistics(const TextStatistics& stats);
+    static void saveStatisticsCSV(const TextStatistics& stats, const std::string& filename);
+    
+    // Индекс русской буквы UTF-8 в позиции pos без учета регистра
+    // (-1 - не русская буква)
+    static int letterIndexUTF8(const unsigned char* bytes, size_t pos, size_t length);
+    
+    // Строчная буква UTF-8 по индексу алфавита
+    static std::string letterFromIndex(int index);
+    
+    // Результат анализа по гистограмме (в частотах только встреченные буквы)
+    static AnalysisResult resultFromHistogram(const LetterHistogram& histogram,
+                                              std::uint64_t totalCharacters);
+    
+    // Подсчет букв по частям текста любого общего размера (в том числе
+    // больше памяти): буква, разрезанная границей частей, учитывается один раз
+    class LetterStream {
+    public:
+        explicit LetterStream(int threads = 0);
+        
+        void add(const char* data, size_t length);
+        void add(const std::string& part) { add(part.data(), part.size()); }
+        
+        AnalysisResult result() const;
+        const LetterHistogram& histogram() const { return histogram_; }
+        std::uint64_t totalCharacters() const { return characters_; }
+        
+    private:
+        int threads_;
+        LetterHistogram histogram_{};
+        std::uint64_t characters_ = 0;
+        unsigned char carry_ = 0;   // Первый байт буквы в конце прошлой части
+    };
+    
+    // Чтение файла целиком
+    static std::string readFileToString(const std::string& filename);
     
     // Статические методы для тестов
     static bool isRussianLetter(char c);
@@ -53,19 +148,14 @@ public:
     static std::string createTestText();
     
 private:
-    // Вспомогательные методы для UTF-8
-    static bool isRussianLetterUTF8(const unsigned char* bytes, size_t& pos, size_t length);
-    static std::string getRussianLetterUTF8(const unsigned char* bytes, size_t pos);
-    static std::string toLowerRussianUTF8(const std::string& letter);
-    
     // Вспомогательные методы
-    static std::string readFileToString(const std::string& filename);
-    static std::vector<std::pair<std::string, int>> sortByFrequency(
-        const std::map<std::string, int>& freq);
+    static std::vector<std::pair<std::string, std::uint64_t>> sortByFrequency(
+        const std::map<std::string, std::uint64_t>& freq);
     static void writePythonPlotScript(const std::string& filename, const std::string& content);
     
     // Основная реализация анализа
-    AnalysisResult analyzeTextImpl(const std::string& text, int threads);
+    AnalysisResult analyzeTextImpl(const std::string& text, const TuningConfig& config,
+                                   const CountingOptions& options);
 };
 
 #endif // BOOK_ANALYZER_HPP
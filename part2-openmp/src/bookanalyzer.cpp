@@ -0,0 +1,144 @@
+#include "bookanalyzer.h"
+#include "book_analyzer.hpp"
+#include "text_encoding.hpp"
+#include <cstring>
+#include <exception>
+#include <new>
+#include <string>
+
+struct ba_context {
+    BookAnalyzer::TuningConfig config;
+    std::string lastError;
+};
+
+namespace {
+
+// Исключения не должны пересекать границу C: ошибка запоминается в контексте
+ba_status fail(ba_context* context, ba_status status, const char* message) {
+    if (context != nullptr) {
+        try {
+            context->lastError = message;
+        } catch (const std::bad_alloc&) {
+            context->lastError.clear();
+        }
+    }
+    return status;
+}
+
+} // namespace
+
+extern "C" {
+
+int ba_api_version(void) {
+    return BA_API_VERSION;
+}
+
+ba_context* ba_context_create(int threads) {
+    ba_context* context = new (std::nothrow) ba_context();
+    if (context != nullptr) {
+        context->config.threads = threads > 0 ? threads : 0;
+    }
+    return context;
+}
+
+void ba_context_destroy(ba_context* context) {
+    delete context;
+}
+
+ba_status ba_context_set_threads(ba_context* context, int threads) {
+    if (context == nullptr || threads < 0) {
+        return fail(context, BA_ERROR_INVALID_ARGUMENT, "threads must be non-negative");
+    }
+    context->config.threads = threads;
+    return BA_OK;
+}
+
+ba_status ba_context_set_chunk(ba_context* context, int chunk_bytes) {
+    if (context == nullptr || chunk_bytes <= 0) {
+        return fail(context, BA_ERROR_INVALID_ARGUMENT, "chunk must be positive");
+    }
+    context->config.chunk = chunk_bytes;
+    return BA_OK;
+}
+
+ba_status ba_count_letters(ba_context* context,
+                           const char* text, size_t length,
+                           ba_encoding encoding,
+                           uint64_t* counts, size_t capacity,
+                           uint64_t* total_letters,
+                           ba_encoding* detected) {
+    if (context == nullptr || counts == nullptr || (text == nullptr && length > 0)) {
+        return fail(context, BA_ERROR_INVALID_ARGUMENT, "null argument");
+    }
+    if (capacity < BA_ALPHABET_SIZE) {
+        return fail(context, BA_ERROR_BUFFER_TOO_SMALL, "counts buffer is smaller than alphabet");
+    }
+    
+    try {
+        TextEncoding textEncoding;
+        switch (encoding) {
+            case BA_ENCODING_AUTO:   textEncoding = TextDecoder::detect(text, length); break;
+            case BA_ENCODING_UTF8:   textEncoding = TextEncoding::UTF8; break;
+            case BA_ENCODING_CP1251: textEncoding = TextEncoding::CP1251; break;
+            case BA_ENCODING_KOI8R:  textEncoding = TextEncoding::KOI8R; break;
+            default:
+                return fail(context, BA_ERROR_INVALID_ARGUMENT, "unknown encoding");
+        }
+        
+        BookAnalyzer::LetterHistogram histogram{};
+        if (length > 0) {
+            histogram = textEncoding == TextEncoding::UTF8
+                ? BookAnalyzer::countLetters(text, length, context->config)
+                : TextDecoder::countLetters(text, length, textEncoding, context->config.threads);
+        }
+        
+        std::uint64_t total = 0;
+        for (int i = 0; i < BookAnalyzer::ALPHABET_SIZE; ++i) {
+            counts[i] = histogram[i];
+            total += histogram[i];
+        }
+        if (total_letters != nullptr) {
+            *total_letters = total;
+        }
+        if (detected != nullptr) {
+            *detected = textEncoding == TextEncoding::UTF8   ? BA_ENCODING_UTF8 :
+                        textEncoding == TextEncoding::CP1251 ? BA_ENCODING_CP1251 :
+                                                               BA_ENCODING_KOI8R;
+        }
+    } catch (const std::bad_alloc&) {
+        return fail(context, BA_ERROR_INTERNAL, "out of memory");
+    } catch (const std::exception& e) {
+        return fail(context, BA_ERROR_INTERNAL, e.what());
+    }
+    
+    context->lastError.clear();
+    return BA_OK;
+}
+
+size_t ba_letter_utf8(int index, char* buffer, size_t capacity) {
+    if (index < 0 || index >= BA_ALPHABET_SIZE || buffer == nullptr) {
+        return 0;
+    }
+    std::string letter = BookAnalyzer::letterFromIndex(index);
+    if (capacity < letter.size() + 1) {
+        return 0;
+    }
+    std::memcpy(buffer, letter.c_str(), letter.size() + 1);
+    return letter.size();
+}
+
+const char* ba_last_error(const ba_context* context) {
+    return context != nullptr ? context->lastError.c_str() : "null context";
+}
+
+const char* ba_status_string(ba_status status) {
+    switch (status) {
+        case BA_OK:                     return "ok";
+        case BA_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case BA_ERROR_BUFFER_TOO_SMALL: return "buffer too small";
+        case BA_ERROR_INTERNAL:         return "internal error";
+    }
+    return "unknown status";
+}
+
+} // extern "C"
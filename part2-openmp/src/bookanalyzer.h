@@ -0,0 +1,91 @@
+/*
+ * libbookanalyzer - C API анализатора частот русских букв.
+ *
+ * Двоичный интерфейс стабилен в пределах старшей версии библиотеки
+ * (SOVERSION): контекст непрозрачен, в функции передаются только
+ * указатели, целые фиксированной ширины и перечисления с явными значениями.
+ * Новые функции добавляются без изменения существующих.
+ *
+ * Текст передается указателем и длиной и не копируется; результаты
+ * пишутся в буферы вызывающей стороны. Контекст хранит настройки
+ * и текст последней ошибки и переиспользуется между вызовами. Один
+ * контекст нельзя использовать из нескольких потоков одновременно,
+ * разные контексты независимы.
+ */
+#ifndef BOOKANALYZER_H
+#define BOOKANALYZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define BA_API __attribute__((visibility("default")))
+#else
+#define BA_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Версия интерфейса, с которой собран вызывающий код */
+#define BA_API_VERSION 1
+
+/* Русский алфавит: индексы строчных букв а-е 0-5, ё 6, ж-я 7-32 */
+#define BA_ALPHABET_SIZE 33
+
+typedef struct ba_context ba_context;
+
+typedef enum ba_status {
+    BA_OK = 0,
+    BA_ERROR_INVALID_ARGUMENT = 1,  /* Нулевой указатель, неизвестное значение */
+    BA_ERROR_BUFFER_TOO_SMALL = 2,  /* Емкость буфера меньше BA_ALPHABET_SIZE */
+    BA_ERROR_INTERNAL = 3           /* Исключение внутри библиотеки */
+} ba_status;
+
+typedef enum ba_encoding {
+    BA_ENCODING_AUTO = 0,           /* Определение по началу текста */
+    BA_ENCODING_UTF8 = 1,
+    BA_ENCODING_CP1251 = 2,
+    BA_ENCODING_KOI8R = 3
+} ba_encoding;
+
+/* Версия интерфейса собранной библиотеки */
+BA_API int ba_api_version(void);
+
+/* Контекст с заданным числом потоков (0 - все доступные).
+ * NULL - не удалось выделить память */
+BA_API ba_context* ba_context_create(int threads);
+BA_API void ba_context_destroy(ba_context* context);
+
+/* Число потоков и размер порции (байтов) для следующих вызовов */
+BA_API ba_status ba_context_set_threads(ba_context* context, int threads);
+BA_API ba_status ba_context_set_chunk(ba_context* context, int chunk_bytes);
+
+/* Подсчет букв text[0..length) без учета регистра.
+ * counts - буфер на capacity >= BA_ALPHABET_SIZE счетчиков, заполняется
+ * полностью (лишние элементы не трогаются). total_letters и detected
+ * необязательны (NULL). Пустой текст допустим, text может быть NULL
+ * только при length == 0 */
+BA_API ba_status ba_count_letters(ba_context* context,
+                                  const char* text, size_t length,
+                                  ba_encoding encoding,
+                                  uint64_t* counts, size_t capacity,
+                                  uint64_t* total_letters,
+                                  ba_encoding* detected);
+
+/* Строчная буква по индексу в UTF-8 с завершающим нулем.
+ * Возвращает длину без нуля (0 - неверный индекс или мал буфер) */
+BA_API size_t ba_letter_utf8(int index, char* buffer, size_t capacity);
+
+/* Текст последней ошибки контекста ("" - ошибок не было).
+ * Действителен до следующего вызова с этим контекстом */
+BA_API const char* ba_last_error(const ba_context* context);
+
+BA_API const char* ba_status_string(ba_status status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOKANALYZER_H */
@@ -0,0 +1,216 @@
+#include "directory_watcher.hpp"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Файл готов к чтению после закрытия на запись или переноса в каталог;
+// IN_MODIFY не используется, чтобы не читать файл на середине записи
+const std::uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                                 IN_DELETE | IN_CREATE | IN_DELETE_SELF;
+
+} // namespace
+
+DirectoryWatcher::DirectoryWatcher(const std::string& root, const std::string& extension,
+                                   int threads)
+    : extension_(extension), threads_(threads) {
+    
+    if (!fs::is_directory(root)) {
+        throw std::runtime_error("Not a directory: " + root);
+    }
+    
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ < 0) {
+        throw std::runtime_error(std::string("inotify_init1 failed: ") + std::strerror(errno));
+    }
+    
+    aggregate_.wordLengths.assign(BookAnalyzer::MAX_WORD_LENGTH + 1, 0);
+    
+    // Наблюдение ставится до чтения файлов: запись, случившаяся во время
+    // начального обхода, придет событием
+    root_ = fs::path(root).lexically_normal().string();
+    if (root_.size() > 1 && root_.back() == '/') {
+        root_.pop_back();
+    }
+    watchTree(root_);
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    if (inotify_ >= 0) {
+        close(inotify_);
+    }
+}
+
+bool DirectoryWatcher::accepts(const std::string& path) const {
+    if (extension_.empty()) {
+        return true;
+    }
+    return path.size() >= extension_.size() &&
+           path.compare(path.size() - extension_.size(), extension_.size(), extension_) == 0;
+}
+
+void DirectoryWatcher::watchTree(const std::string& directory) {
+    int wd = inotify_add_watch(inotify_, directory.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        // Каталог могли удалить сразу после создания
+        return;
+    }
+    watches_[wd] = directory;
+    
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(directory, error)) {
+        std::string path = entry.path().string();
+        
+        // Ссылки на каталоги не обходятся: цикл ссылок дал бы бесконечную рекурсию
+        if (entry.is_symlink(error) && entry.is_directory(error)) {
+            continue;
+        }
+        if (entry.is_directory(error)) {
+            watchTree(path);
+        } else if (entry.is_regular_file(error) && accepts(path)) {
+            updateFile(path);
+        }
+    }
+}
+
+void DirectoryWatcher::updateFile(const std::string& path) {
+    std::string text;
+    try {
+        text = BookAnalyzer::readFileToString(path);
+    } catch (const std::exception&) {
+        // Файл исчез между событием и чтением - придет IN_DELETE
+        return;
+    }
+    
+    BookAnalyzer analyzer;
+    auto stats = analyzer.analyzeStatistics(text, threads_);
+    analyzed_++;
+    
+    auto old = files_.find(path);
+    if (old != files_.end()) {
+        aggregate_.subtract(old->second);
+        old->second = stats;
+    } else {
+        files_.emplace(path, stats);
+    }
+    aggregate_.add(stats);
+}
+
+void DirectoryWatcher::removeFile(const std::string& path) {
+    auto old = files_.find(path);
+    if (old != files_.end()) {
+        aggregate_.subtract(old->second);
+        files_.erase(old);
+    }
+}
+
+void DirectoryWatcher::removeTree(const std::string& directory) {
+    std::string prefix = directory + "/";
+    for (auto it = files_.lower_bound(prefix);
+         it != files_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ) {
+        aggregate_.subtract(it->second);
+        it = files_.erase(it);
+    }
+    
+    // Перенесенный каталог продолжает жить под другим именем:
+    // наблюдение за ним и подкаталогами снимается явно
+    for (auto it = watches_.begin(); it != watches_.end(); ) {
+        if (it->second == directory || it->second.compare(0, prefix.size(), prefix) == 0) {
+            inotify_rm_watch(inotify_, it->first);
+            it = watches_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Полный пересчет после потери событий. Наблюдения за существующими
+// каталогами сохраняются (inotify_add_watch вернет тот же дескриптор),
+// за удаленными - снимутся ядром событием IN_IGNORED
+void DirectoryWatcher::rescan() {
+    files_.clear();
+    aggregate_ = BookAnalyzer::TextStatistics();
+    aggregate_.wordLengths.assign(BookAnalyzer::MAX_WORD_LENGTH + 1, 0);
+    watchTree(root_);
+}
+
+size_t DirectoryWatcher::poll(int timeoutMs) {
+    pollfd fd{inotify_, POLLIN, 0};
+    if (::poll(&fd, 1, timeoutMs) <= 0) {
+        return 0;
+    }
+    
+    // Все накопившиеся события разбираются до пересчета: несколько
+    // записей в один файл дают один пересчет
+    std::set<std::string> changed;
+    std::set<std::string> removed;
+    bool overflow = false;
+    alignas(inotify_event) char buffer[64 * 1024];
+    
+    while (true) {
+        ssize_t length = read(inotify_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        
+        for (char* ptr = buffer; ptr < buffer + length; ) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+            
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches_.erase(event->wd);
+                continue;
+            }
+            auto watch = watches_.find(event->wd);
+            if (watch == watches_.end() || event->len == 0) {
+                continue;
+            }
+            std::string path = watch->second + "/" + event->name;
+            
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    watchTree(path);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    removeTree(path);
+                }
+                continue;
+            }
+            if (!accepts(path)) {
+                continue;
+            }
+            
+            if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                changed.erase(path);
+                removed.insert(path);
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                removed.erase(path);
+                changed.insert(path);
+            }
+        }
+    }
+    
+    if (overflow) {
+        overflows_++;
+        rescan();
+        return files_.size();
+    }
+    
+    for (const auto& path : removed) {
+        removeFile(path);
+    }
+    for (const auto& path : changed) {
+        updateFile(path);
+    }
+    return removed.size() + changed.size();
+}
@@ -0,0 +1,58 @@
+#ifndef DIRECTORY_WATCHER_HPP
+#define DIRECTORY_WATCHER_HPP
+
+#include "book_analyzer.hpp"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+// Сводный профиль (буквы, слова, предложения, длины слов) дерева каталогов,
+// поддерживаемый по событиям inotify. Изменившийся файл пересчитывается
+// целиком: его старый профиль вычитается из сводного, новый прибавляется.
+// Неизменившиеся файлы повторно не читаются
+class DirectoryWatcher {
+public:
+    // extension - учитывать только файлы с этим окончанием (пусто - все)
+    explicit DirectoryWatcher(const std::string& root, const std::string& extension = "",
+                              int threads = 0);
+    ~DirectoryWatcher();
+    
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+    
+    // Ожидание событий до timeoutMs и применение изменений.
+    // Возвращает число пересчитанных или удаленных файлов. При
+    // переполнении очереди inotify события потеряны, и дерево
+    // пересчитывается целиком (см. overflows())
+    size_t poll(int timeoutMs);
+    
+    const BookAnalyzer::TextStatistics& aggregate() const { return aggregate_; }
+    size_t fileCount() const { return files_.size(); }
+    
+    // Сколько раз файлы читались и анализировались с момента создания
+    std::uint64_t analyzedFiles() const { return analyzed_; }
+    
+    // Сколько раз очередь событий переполнялась
+    std::uint64_t overflows() const { return overflows_; }
+    
+private:
+    void watchTree(const std::string& directory);
+    void updateFile(const std::string& path);
+    void removeFile(const std::string& path);
+    void removeTree(const std::string& directory);
+    void rescan();
+    bool accepts(const std::string& path) const;
+    
+    std::string root_;
+    std::string extension_;
+    int threads_;
+    int inotify_ = -1;
+    std::map<int, std::string> watches_;    // Дескриптор наблюдения -> каталог
+    std::map<std::string, BookAnalyzer::TextStatistics> files_;
+    BookAnalyzer::TextStatistics aggregate_;
+    std::uint64_t analyzed_ = 0;
+    std::uint64_t overflows_ = 0;
+};
+
+#endif // DIRECTORY_WATCHER_HPP
@@ -0,0 +1,210 @@
+#include "frequency_index.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <omp.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Заголовок файла индекса; за ним count * ALPHABET_SIZE чисел uint64
+struct IndexHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t stride;
+    std::uint64_t textLength;
+    std::uint64_t count;
+};
+
+const char INDEX_MAGIC[4] = {'F', 'I', 'D', 'X'};
+const std::uint32_t INDEX_VERSION = 1;
+
+// Досчет букв, первый байт которых лежит в [from, to)
+void countRange(const unsigned char* bytes, size_t length, size_t from, size_t to,
+                BookAnalyzer::LetterHistogram& histogram) {
+    for (size_t i = from; i < to; ++i) {
+        int index = BookAnalyzer::letterIndexUTF8(bytes, i, length);
+        if (index >= 0) {
+            histogram[index]++;
+            i++;  // Второй байт буквы
+        }
+    }
+}
+
+} // namespace
+
+FrequencyIndex::FrequencyIndex()
+    : stride_(DEFAULT_STRIDE), textLength_(0), count_(1),
+      owned_(BookAnalyzer::ALPHABET_SIZE, 0), mapped_(nullptr) {}
+
+FrequencyIndex FrequencyIndex::build(const std::string& text, size_t stride, int threads) {
+    if (stride < 2) {
+        throw std::invalid_argument("Index stride must be at least 2 bytes");
+    }
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    size_t length = text.length();
+    size_t blocks = (length + stride - 1) / stride;
+    const size_t A = BookAnalyzer::ALPHABET_SIZE;
+    
+    FrequencyIndex index;
+    index.stride_ = stride;
+    index.textLength_ = length;
+    index.count_ = blocks + 1;
+    index.owned_.assign(index.count_ * A, 0);
+    
+    // Точка j + 1 сначала получает гистограмму блока j
+    std::uint64_t* points = index.owned_.data();
+    
+    #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+    for (size_t block = 0; block < blocks; ++block) {
+        size_t from = block * stride;
+        size_t to = std::min(length, from + stride);
+        
+        // Буква на границе блоков принадлежит блоку своего первого байта
+        BookAnalyzer::LetterHistogram local{};
+        countRange(bytes, length, from, to, local);
+        std::copy(local.begin(), local.end(), points + (block + 1) * A);
+    }
+    
+    // Префиксные суммы по блокам
+    for (size_t j = 1; j < index.count_; ++j) {
+        for (size_t a = 0; a < A; ++a) {
+            points[j * A + a] += points[(j - 1) * A + a];
+        }
+    }
+    
+    return index;
+}
+
+const std::uint64_t* FrequencyIndex::checkpoint(size_t index) const {
+    if (index >= count_) {
+        throw std::out_of_range("Checkpoint index out of range");
+    }
+    return data() + index * BookAnalyzer::ALPHABET_SIZE;
+}
+
+void FrequencyIndex::prefix(const unsigned char* bytes, size_t position,
+                            BookAnalyzer::LetterHistogram& result) const {
+    size_t block = position / stride_;
+    const std::uint64_t* point = checkpoint(block);
+    std::copy(point, point + BookAnalyzer::ALPHABET_SIZE, result.begin());
+    
+    // Первый байт буквы (0xD0/0xD1) не бывает вторым байтом другой
+    // буквы, поэтому досчет можно начинать с любой позиции
+    countRange(bytes, textLength_, block * stride_, position, result);
+}
+
+BookAnalyzer::LetterHistogram FrequencyIndex::histogram(const std::string& text,
+                                                        size_t begin, size_t end) const {
+    if (text.length() != textLength_) {
+        throw std::runtime_error("Text does not match frequency index");
+    }
+    if (begin > end || end > textLength_) {
+        throw std::out_of_range("Invalid range for frequency index query");
+    }
+    
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    
+    BookAnalyzer::LetterHistogram left;
+    BookAnalyzer::LetterHistogram right;
+    prefix(bytes, begin, left);
+    prefix(bytes, end, right);
+    
+    for (int a = 0; a < BookAnalyzer::ALPHABET_SIZE; ++a) {
+        right[a] -= left[a];
+    }
+    
+    // Буква, разрезанная правой границей, в подстроку не входит
+    // (как при анализе text.substr(begin, end - begin))
+    if (end > begin) {
+        int cut = BookAnalyzer::letterIndexUTF8(bytes, end - 1, textLength_);
+        if (cut >= 0) {
+            right[cut]--;
+        }
+    }
+    return right;
+}
+
+BookAnalyzer::AnalysisResult FrequencyIndex::query(const std::string& text,
+                                                   size_t begin, size_t end) const {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    auto result = BookAnalyzer::resultFromHistogram(histogram(text, begin, end), end - begin);
+    
+    result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime
+    );
+    return result;
+}
+
+void FrequencyIndex::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    IndexHeader header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.stride = stride_;
+    header.textLength = textLength_;
+    header.count = count_;
+    
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(data()),
+               count_ * BookAnalyzer::ALPHABET_SIZE * sizeof(std::uint64_t));
+    if (!file) {
+        throw std::runtime_error("Cannot write file: " + filename);
+    }
+}
+
+FrequencyIndex FrequencyIndex::load(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(IndexHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid frequency index file: " + filename);
+    }
+    
+    size_t size = static_cast<size_t>(st.st_size);
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Cannot map file: " + filename);
+    }
+    
+    // Отображение живет, пока жива хотя бы одна копия индекса
+    std::shared_ptr<void> mapping(address, [size](void* p) { ::munmap(p, size); });
+    
+    IndexHeader header;
+    std::memcpy(&header, address, sizeof(header));
+    size_t expected = sizeof(IndexHeader) +
+        header.count * BookAnalyzer::ALPHABET_SIZE * sizeof(std::uint64_t);
+    if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header.version != INDEX_VERSION || header.stride < 2 || size != expected ||
+        header.count != (header.textLength + header.stride - 1) / header.stride + 1) {
+        throw std::runtime_error("Invalid frequency index file: " + filename);
+    }
+    
+    FrequencyIndex index;
+    index.stride_ = header.stride;
+    index.textLength_ = header.textLength;
+    index.count_ = header.count;
+    index.owned_.clear();
+    index.mapping_ = std::move(mapping);
+    index.mapped_ = reinterpret_cast<const std::uint64_t*>(
+        static_cast<const char*>(address) + sizeof(IndexHeader));
+    return index;
+}
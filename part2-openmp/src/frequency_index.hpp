@@ -0,0 +1,64 @@
+#ifndef FREQUENCY_INDEX_HPP
+#define FREQUENCY_INDEX_HPP
+
+#include "book_analyzer.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Индекс частот для запросов по диапазонам байтов одного текста.
+// Через каждые stride байтов хранится накопленная гистограмма букв
+// от начала текста, поэтому запрос [begin, end) стоит O(33 + stride):
+// разность двух контрольных точек плюс досчет двух неполных блоков.
+// Буква относится к блоку, в котором лежит ее первый байт
+class FrequencyIndex {
+public:
+    static constexpr size_t DEFAULT_STRIDE = 64 * 1024;
+    
+    FrequencyIndex();
+    
+    // Параллельное построение: гистограммы блоков считаются потоками
+    // OpenMP, затем последовательно складываются в префиксные суммы
+    static FrequencyIndex build(const std::string& text,
+                                size_t stride = DEFAULT_STRIDE,
+                                int threads = 0);
+    
+    // Гистограмма букв в байтах [begin, end) того же текста
+    BookAnalyzer::LetterHistogram histogram(const std::string& text,
+                                            size_t begin, size_t end) const;
+    
+    // То же в виде результата анализа (как у analyzeText для подстроки)
+    BookAnalyzer::AnalysisResult query(const std::string& text,
+                                       size_t begin, size_t end) const;
+    
+    // Двоичный файл: заголовок и контрольные точки подряд (uint64).
+    // load отображает файл в память без копирования
+    void save(const std::string& filename) const;
+    static FrequencyIndex load(const std::string& filename);
+    
+    size_t stride() const { return stride_; }
+    size_t textLength() const { return textLength_; }
+    size_t checkpointCount() const { return count_; }
+    
+    // Накопленная гистограмма [0, index * stride)
+    const std::uint64_t* checkpoint(size_t index) const;
+    
+private:
+    // Гистограмма [0, position): ближайшая точка слева плюс досчет
+    void prefix(const unsigned char* bytes, size_t position,
+                BookAnalyzer::LetterHistogram& result) const;
+    
+    size_t stride_;
+    size_t textLength_;
+    size_t count_;
+    
+    const std::uint64_t* data() const { return mapping_ ? mapped_ : owned_.data(); }
+    
+    // Точки лежат либо в собственном векторе, либо в отображенном файле
+    std::vector<std::uint64_t> owned_;
+    std::shared_ptr<void> mapping_;
+    const std::uint64_t* mapped_;
+};
+
+#endif // FREQUENCY_INDEX_HPP
@@ -0,0 +1,115 @@
+#ifndef LETTER_KERNEL_HPP
+#define LETTER_KERNEL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Ядро подсчета русских букв UTF-8, специализируемое при компиляции.
+// Алфавит и учет регистра задаются классами-политиками, по ним строится
+// constexpr-таблица: второй байт буквы (0xD0/0xD1 + продолжение) сразу
+// отображается в номер счетчика. Каждая комбинация параметров шаблона
+// компилируется в отдельный цикл без вызовов и ветвлений по типу буквы;
+// выбор комбинации - во время выполнения (BookAnalyzer::analyzeTextImpl)
+class LetterKernel {
+public:
+    // Счетчики: 0-32 строчные буквы (индексы letterIndexUTF8),
+    // 33-65 заглавные при учете регистра, SINK - пары 0xD0/0xD1 + продолжение,
+    // не являющиеся буквами (считаются, чтобы не ветвиться)
+    static constexpr int LOWER_SLOTS = 33;
+    static constexpr int SINK = 2 * LOWER_SLOTS;
+    static constexpr int SLOTS = SINK + 1;
+    
+    template <typename Counter>
+    using Counters = std::array<Counter, SLOTS>;
+    using Totals = std::array<std::uint64_t, SLOTS>;
+    
+    // Каждый засчитанный слот начинается в своем байте диапазона, поэтому
+    // после стольких байтов узкие счетчики нужно сбросить в 64-битные
+    template <typename Counter>
+    static constexpr std::uint64_t flushBytes() {
+        return std::numeric_limits<Counter>::max();
+    }
+    
+    template <typename Counter>
+    static void flush(Counters<Counter>& counters, Totals& totals) {
+        for (int s = 0; s < SLOTS; ++s) {
+            totals[s] += counters[s];
+            counters[s] = 0;
+        }
+    }
+    
+    // Политики алфавита
+    struct Russian {
+        static constexpr bool yoAsYe = false;
+    };
+    struct RussianYoAsYe {            // ё считается как е
+        static constexpr bool yoAsYe = true;
+    };
+    
+    // Политики регистра
+    struct FoldCase {
+        static constexpr bool fold = true;
+    };
+    struct KeepCase {
+        static constexpr bool fold = false;
+    };
+    
+    // Таблица на 128 элементов: индекс ((c1 & 1) << 6) | (c2 & 0x3F)
+    template <class Alphabet, class CaseMode>
+    static constexpr std::array<std::uint8_t, 128> makeTable() {
+        std::array<std::uint8_t, 128> table{};
+        for (auto& slot : table) {
+            slot = SINK;
+        }
+        
+        auto put = [&table](int c1, int c2, int letter, bool upper) {
+            if (Alphabet::yoAsYe && letter == 6) {
+                letter = 5;
+            }
+            int slot = (upper && !CaseMode::fold) ? letter + LOWER_SLOTS : letter;
+            table[((c1 & 1) << 6) | (c2 & 0x3F)] = static_cast<std::uint8_t>(slot);
+        };
+        
+        put(0xD0, 0x81, 6, true);                              // Ё
+        put(0xD1, 0x91, 6, false);                             // ё
+        for (int k = 0; k < 16; ++k) {
+            int letter = k < 6 ? k : k + 1;
+            put(0xD0, 0x90 + k, letter, true);                 // А-П
+            put(0xD0, 0xB0 + k, letter, false);                // а-п
+            put(0xD0, 0xA0 + k, 17 + k, true);                 // Р-Я
+            put(0xD1, 0x80 + k, 17 + k, false);                // р-я
+        }
+        return table;
+    }
+    
+    template <class Alphabet, class CaseMode>
+    static constexpr std::array<std::uint8_t, 128> table = makeTable<Alphabet, CaseMode>();
+    
+    // Подсчет букв, начинающихся в [from, to). Буква на правой границе
+    // дочитывается (второй байт до length), а байт-продолжение в начале
+    // диапазона букву не начинает, поэтому диапазоны можно резать где угодно
+    template <class Alphabet, class CaseMode, typename Counter>
+    static inline void count(const unsigned char* data, size_t from, size_t to, size_t length,
+                             Counters<Counter>& counters) {
+        const auto& slots = table<Alphabet, CaseMode>;
+        size_t end = to < length ? to : (length > 0 ? length - 1 : 0);
+        
+        size_t i = from;
+        while (i < end) {
+            unsigned char c1 = data[i];
+            if ((c1 & 0xFE) != 0xD0) {
+                ++i;
+                continue;
+            }
+            unsigned char c2 = data[i + 1];
+            bool continuation = (c2 & 0xC0) == 0x80;
+            counters[continuation ? slots[((c1 & 1) << 6) | (c2 & 0x3F)] : SINK]++;
+            // Продолжение не может начинать букву - перешагиваем его
+            i += continuation ? 2 : 1;
+        }
+    }
+};
+
+#endif // LETTER_KERNEL_HPP
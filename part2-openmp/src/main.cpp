@@ -1,15 +1,367 @@
 #include "book_analyzer.hpp"
+#include "frequency_index.hpp"
+#include "sliding_window.hpp"
+#include "text_encoding.hpp"
+#include "sampling_analyzer.hpp"
+#include "word_sketch.hpp"
+#include "phrase_matcher.hpp"
+#include "auto_tuner.hpp"
+#include "async_reader.hpp"
+#include "analysis_server.hpp"
+#include "directory_watcher.hpp"
+#include "profile_matcher.hpp"
 #include <iostream>
 #include <vector>
+#include <string>
 #include <filesystem>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 
+static void printModeUsage(const char* program) {
+    std::cout << "\nUsage: " << program << " <book_file.txt> [threads]" << std::endl;
+    std::cout << "       " << program << " --mode index <book_file.txt> <index_file> [stride] [threads]" << std::endl;
+    std::cout << "       " << program << " --mode query <book_file.txt> <index_file> <begin> <end>" << std::endl;
+    std::cout << "       " << program << " --mode corpus [--encoding auto|utf-8|cp1251|koi8-r]"
+              << " [--reader auto|io_uring|threads] [--depth n] <file>..." << std::endl;
+    std::cout << "       " << program << " --mode sample <file> [target_error] [block_kb] [threads]" << std::endl;
+    std::cout << "       " << program << " --mode sketch <file> [top] [threads] [--compare-exact]" << std::endl;
+    std::cout << "       " << program << " --mode phrases <file> <patterns.txt> [threads] [output.csv]" << std::endl;
+    std::cout << "       " << program << " --mode tune <file> [profile]" << std::endl;
+    std::cout << "       " << program << " --mode serve <socket> [threads] [batch_window_us] [max_text_bytes]" << std::endl;
+    std::cout << "       " << program << " --mode request <socket> file|text <path> | stats | shutdown" << std::endl;
+    std::cout << "       " << program << " --mode watch <directory> [extension] [threads]" << std::endl;
+    std::cout << "       " << program << " --mode profile <profiles.txt> <file>..." << std::endl;
+    std::cout << "       " << program << " --mode match <profiles.txt> [--metric chi2|kl|cosine] <file>..." << std::endl;
+    std::cout << "       " << program << " --mode stats <book_file.txt> [threads] [output.csv]" << std::endl;
+    std::cout << "       " << program << " --mode window <book_file.txt> <window> <step> <output.csv> [output.bin] [threads]" << std::endl;
+}
+
+// Разбор --mode: каждый режим (индекс, корпус, скетч, сервер, наблюдение
+// за каталогом, профили и т.д.) получает свои позиционные аргументы.
+// Неизвестный режим или нехватка аргументов - справка и код 1
+static int runMode(const std::string& mode, const std::vector<std::string>& args,
+                   const char* program) {
+    if (mode == "index" && args.size() >= 2) {
+        size_t stride = args.size() > 2 ? std::stoull(args[2]) : FrequencyIndex::DEFAULT_STRIDE;
+        int threads = args.size() > 3 ? std::stoi(args[3]) : 0;
+        
+        std::string text = BookAnalyzer::readFileToString(args[0]);
+        auto start = std::chrono::high_resolution_clock::now();
+        auto index = FrequencyIndex::build(text, stride, threads);
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start);
+        index.save(args[1]);
+        
+        std::cout << "\nIndex built: " << index.checkpointCount() << " checkpoints, stride "
+                  << index.stride() << " bytes, " << duration.count() << " us" << std::endl;
+        std::cout << "Saved to: " << args[1] << std::endl;
+        return 0;
+    }
+    
+    if (mode == "query" && args.size() >= 4) {
+        std::string text = BookAnalyzer::readFileToString(args[0]);
+        auto index = FrequencyIndex::load(args[1]);
+        size_t begin = std::stoull(args[2]);
+        size_t end = std::stoull(args[3]);
+        
+        auto result = index.query(text, begin, end);
+        std::cout << "\nRange [" << begin << ", " << end << ")" << std::endl;
+        BookAnalyzer::printResults(result, 20);
+        return 0;
+    }
+    
+    if (mode == "corpus" && !args.empty()) {
+        // Кодировка определяется для каждого файла отдельно,
+        // если не задана явно
+        AsyncReaderOptions options;
+        std::vector<std::string> files;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "--encoding" && i + 1 < args.size()) {
+                std::string forced = args[++i];
+                options.detectEncoding = forced == "auto";
+                if (!options.detectEncoding) {
+                    options.encoding = TextDecoder::parse(forced);
+                }
+            } else if (args[i] == "--reader" && i + 1 < args.size()) {
+                options.backend = AsyncCorpusReader::parseBackend(args[++i]);
+            } else if (args[i] == "--depth" && i + 1 < args.size()) {
+                options.queueDepth = static_cast<unsigned>(std::stoul(args[++i]));
+            } else {
+                files.push_back(args[i]);
+            }
+        }
+        
+        AsyncCorpusReader reader(options);
+        std::cout << "Reader: " << AsyncCorpusReader::backendName(reader.backend())
+                  << ", queue depth " << options.queueDepth << std::endl;
+        
+        BookAnalyzer::LetterHistogram total{};
+        std::uint64_t totalCharacters = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        for (const auto& file : reader.count(files)) {
+            std::uint64_t letters = 0;
+            for (int a = 0; a < BookAnalyzer::ALPHABET_SIZE; ++a) {
+                total[a] += file.letters[a];
+                letters += file.letters[a];
+            }
+            totalCharacters += file.bytes;
+            
+            std::cout << " " << file.path << ": " << TextDecoder::name(file.encoding)
+                      << ", " << letters << " letters" << std::endl;
+        }
+        
+        auto result = BookAnalyzer::resultFromHistogram(total, totalCharacters);
+        result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start);
+        
+        std::cout << "\nCorpus: " << files.size() << " files" << std::endl;
+        BookAnalyzer::printResults(result, 20);
+        BookAnalyzer::saveFrequencyCSV(result, "corpus_frequencies.csv");
+        return 0;
+    }
+    
+    if (mode == "sample" && !args.empty()) {
+        SamplingOptions options;
+        if (args.size() > 1) options.targetError = std::stod(args[1]);
+        if (args.size() > 2) options.blockSize = std::stoull(args[2]) * 1024;
+        if (args.size() > 3) options.threads = std::stoi(args[3]);
+        
+        auto result = SamplingAnalyzer::analyzeFile(args[0], options);
+        SamplingAnalyzer::printResults(result);
+        return 0;
+    }
+    
+    if (mode == "sketch" && !args.empty()) {
+        // Точный подсчет держит все слова в памяти - только по запросу
+        bool compareExact = false;
+        std::vector<std::string> positional;
+        for (const auto& arg : args) {
+            if (arg == "--compare-exact") {
+                compareExact = true;
+            } else {
+                positional.push_back(arg);
+            }
+        }
+        
+        WordSketchOptions options;
+        if (positional.size() > 1) options.topK = std::stoull(positional[1]);
+        if (positional.size() > 2) options.threads = std::stoi(positional[2]);
+        
+        auto sketch = WordSketchAnalyzer::analyzeFile(positional.at(0), options);
+        if (compareExact) {
+            std::string text = BookAnalyzer::readFileToString(positional[0]);
+            auto exact = WordSketchAnalyzer::exactCounts(text, options.threads);
+            WordSketchAnalyzer::printComparison(sketch, exact);
+        } else {
+            WordSketchAnalyzer::printResults(sketch);
+        }
+        return 0;
+    }
+    
+    if (mode == "phrases" && args.size() >= 2) {
+        int threads = args.size() > 2 ? std::stoi(args[2]) : 0;
+        
+        PhraseMatcher matcher(PhraseMatcher::loadPatterns(args[1]));
+        std::cout << "\nAutomaton: " << matcher.patternCount() << " phrases, "
+                  << matcher.stateCount() << " states, "
+                  << matcher.classCount() << " byte classes" << std::endl;
+        
+        auto result = matcher.countResult(BookAnalyzer::readFileToString(args[0]), threads);
+        BookAnalyzer::printResults(result, 20);
+        BookAnalyzer::saveFrequencyCSV(result, args.size() > 3 ? args[3] : "phrase_counts.csv");
+        return 0;
+    }
+    
+    if (mode == "tune" && !args.empty()) {
+        std::string text = BookAnalyzer::readFileToString(args[0]);
+        AutoTuner tuner(args.size() > 1 ? args[1] : "");
+        
+        std::string source;
+        auto config = tuner.choose(text, &source);
+        tuner.save();
+        
+        std::cout << "\nSize class: 2^" << AutoTuner::sizeClass(text.size())
+                  << " bytes, decision from " << source << std::endl;
+        std::cout << "Chosen: " << config.threads << " threads, "
+                  << BookAnalyzer::scheduleName(config.schedule) << ", chunk "
+                  << config.chunk << std::endl;
+        
+        // Сравнение с конфигурацией по умолчанию на всем файле
+        BookAnalyzer analyzer;
+        auto tuned = analyzer.analyzeTextWith(text, config);
+        auto baseline = analyzer.analyzeText(text);
+        std::cout << "Tuned: " << tuned.processingTime.count() / 1000.0 << " ms, default ("
+                  << baseline.threadsUsed << " threads, dynamic, chunk 4096): "
+                  << baseline.processingTime.count() / 1000.0 << " ms" << std::endl;
+        return 0;
+    }
+    
+    if (mode == "serve" && !args.empty()) {
+        ServerOptions options;
+        options.socketPath = args[0];
+        if (args.size() > 1) options.threads = std::stoi(args[1]);
+        if (args.size() > 2) options.batchWindowMicros = std::stoi(args[2]);
+        if (args.size() > 3) options.maxTextBytes = std::stoull(args[3]);
+        
+        AnalysisServer server(options);
+        std::cout << "Listening on " << options.socketPath << std::endl;
+        server.run();
+        
+        auto stats = server.latency();
+        std::cout << "Served " << stats.requests << " requests, latency p50 " << stats.p50
+                  << " us, p99 " << stats.p99 << " us" << std::endl;
+        return 0;
+    }
+    
+    if (mode == "request" && args.size() >= 2) {
+        const std::string& socket = args[0];
+        const std::string& command = args[1];
+        
+        if ((command == "file" || command == "text") && args.size() >= 3) {
+            // Путь передается абсолютным: у сервера своя рабочая директория
+            std::string response = command == "file"
+                ? AnalysisServer::request(socket, "FILE " + fs::absolute(args[2]).string())
+                : [&] {
+                      std::string text = BookAnalyzer::readFileToString(args[2]);
+                      return AnalysisServer::request(socket, "TEXT " + std::to_string(text.size()),
+                                                     text);
+                  }();
+            BookAnalyzer::printResults(AnalysisServer::parseResponse(response), 10);
+            return 0;
+        }
+        if (command == "stats" || command == "shutdown") {
+            std::string upper = command == "stats" ? "STATS" : "SHUTDOWN";
+            std::cout << AnalysisServer::request(socket, upper) << std::endl;
+            return 0;
+        }
+    }
+    
+    if (mode == "watch" && !args.empty()) {
+        std::string extension = args.size() > 1 ? args[1] : "";
+        int threads = args.size() > 2 ? std::stoi(args[2]) : 0;
+        
+        DirectoryWatcher watcher(args[0], extension, threads);
+        auto report = [&watcher](size_t updated) {
+            const auto& profile = watcher.aggregate();
+            std::cout << watcher.fileCount() << " files: " << profile.totalLetters
+                      << " letters, " << profile.words << " words, " << profile.sentences
+                      << " sentences (updated " << updated << ", analyzed "
+                      << watcher.analyzedFiles() << " in total)" << std::endl;
+        };
+        
+        std::cout << "Watching " << args[0] << " (Ctrl+C to stop)" << std::endl;
+        report(watcher.fileCount());
+        while (true) {
+            size_t updated = watcher.poll(1000);
+            if (updated > 0) {
+                report(updated);
+            }
+        }
+    }
+    
+    if ((mode == "profile" || mode == "match") && args.size() >= 2) {
+        ProfileMetric metric = ProfileMetric::ChiSquare;
+        std::vector<std::string> files;
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--metric" && i + 1 < args.size()) {
+                metric = ProfileMatcher::parseMetric(args[++i]);
+            } else {
+                files.push_back(args[i]);
+            }
+        }
+        
+        // Буквы каждого файла в его собственной кодировке
+        std::vector<ReferenceProfile> documents;
+        for (const auto& file : files) {
+            std::string text = BookAnalyzer::readFileToString(file);
+            TextEncoding encoding = TextDecoder::detect(text);
+            documents.push_back({fs::path(file).stem().string(),
+                                 TextDecoder::countLetters(text, encoding)});
+        }
+        
+        if (mode == "profile") {
+            ProfileMatcher::saveProfiles(documents, args[0]);
+            std::cout << "\nSaved " << documents.size() << " profiles to: " << args[0] << std::endl;
+            return 0;
+        }
+        
+        ProfileMatcher matcher(ProfileMatcher::loadProfiles(args[0]));
+        std::vector<BookAnalyzer::LetterHistogram> histograms;
+        for (const auto& document : documents) {
+            histograms.push_back(document.letters);
+        }
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        auto scores = matcher.score(histograms, metric);
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start);
+        
+        std::cout << "\n" << files.size() << " documents x " << matcher.profileCount()
+                  << " profiles, metric " << ProfileMatcher::metricName(metric) << ", "
+                  << duration.count() << " us" << std::endl;
+        for (size_t d = 0; d < files.size(); ++d) {
+            const double* row = scores.data() + d * matcher.profileCount();
+            size_t best = std::min_element(row, row + matcher.profileCount()) - row;
+            std::cout << " " << files[d] << ": " << matcher.profileName(best)
+                      << " (" << row[best] << ")" << std::endl;
+        }
+        return 0;
+    }
+    
+    if (mode == "stats" && args.size() >= 1) {
+        int threads = args.size() > 1 ? std::stoi(args[1]) : 0;
+        
+        BookAnalyzer analyzer;
+        auto stats = analyzer.analyzeStatistics(BookAnalyzer::readFileToString(args[0]), threads);
+        BookAnalyzer::printStatistics(stats);
+        BookAnalyzer::saveStatisticsCSV(stats, args.size() > 2 ? args[2] : "text_statistics.csv");
+        return 0;
+    }
+    
+    if (mode == "window" && args.size() >= 4) {
+        size_t window = std::stoull(args[1]);
+        size_t step = std::stoull(args[2]);
+        int threads = args.size() > 5 ? std::stoi(args[5]) : 0;
+        
+        std::string text = BookAnalyzer::readFileToString(args[0]);
+        auto start = std::chrono::high_resolution_clock::now();
+        auto series = SlidingWindowAnalyzer::compute(text, window, step, threads);
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start);
+        
+        std::cout << "\nWindows: " << series.windows() << " (window " << window
+                  << " letters, step " << step << ", " << series.totalLetters
+                  << " letters total), " << duration.count() << " us" << std::endl;
+        
+        SlidingWindowAnalyzer::saveCSV(series, args[3]);
+        if (args.size() > 4) {
+            SlidingWindowAnalyzer::saveBinary(series, args[4]);
+        }
+        return 0;
+    }
+    
+    std::cout << "\nERROR: Unknown mode or missing arguments: " << mode << std::endl;
+    printModeUsage(program);
+    return 1;
+}
+
 int main(int argc, char* argv[]) {
     std::cout << "    OpenMP Russian Text Analyzer" << std::endl;
     std::cout << "    Book: Brothers Karamazov" << std::endl;
     std::cout << "    Author: Fyodor Dostoevsky" << std::endl;
     
+    // Дополнительные режимы: --mode <name> <аргументы режима>
+    if (argc > 2 && std::string(argv[1]) == "--mode") {
+        try {
+            return runMode(argv[2], std::vector<std::string>(argv + 3, argv + argc), argv[0]);
+        } catch (const std::exception& e) {
+            std::cerr << "\nError: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    
     // Путь к файлу по умолчанию
     std::string filename;
     if (argc > 1) {
@@ -34,7 +386,7 @@ int main(int argc, char* argv[]) {
         if (filename.empty()) {
             std::cout << "\nERROR: Book file not found!" << std::endl;
             std::cout << "Please provide the path to 'karamazov.txt'" << std::endl;
-            std::cout << "\nUsage: " << argv[0] << " <book_file.txt> [threads]" << std::endl;
+            printModeUsage(argv[0]);
             std::cout << "Example: " << argv[0] << " data/karamazov.txt 4" << std::endl;
             return 1;
         }
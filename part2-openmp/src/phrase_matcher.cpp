@@ -0,0 +1,183 @@
+#include "phrase_matcher.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <omp.h>
+
+PhraseMatcher::PhraseMatcher(const std::vector<std::string>& patterns)
+    : patterns_(patterns), byteClass_(256, 0), classes_(1), maxLength_(0) {
+    
+    if (patterns_.empty()) {
+        throw std::invalid_argument("Phrase list is empty");
+    }
+    
+    // Классы байтов: 0 - байты вне фраз, остальные по порядку появления
+    for (const auto& pattern : patterns_) {
+        if (pattern.empty()) {
+            throw std::invalid_argument("Empty phrase");
+        }
+        maxLength_ = std::max(maxLength_, pattern.size());
+        for (unsigned char c : pattern) {
+            if (byteClass_[c] == 0) {
+                byteClass_[c] = static_cast<std::uint16_t>(classes_++);
+            }
+        }
+    }
+    
+    // Бор: -1 - перехода нет
+    transitions_.assign(classes_, -1);
+    fail_.assign(1, 0);
+    patternState_.reserve(patterns_.size());
+    
+    for (const auto& pattern : patterns_) {
+        std::int32_t state = 0;
+        for (unsigned char c : pattern) {
+            size_t slot = state * classes_ + byteClass_[c];
+            if (transitions_[slot] < 0) {
+                std::int32_t next = static_cast<std::int32_t>(fail_.size());
+                transitions_[slot] = next;
+                transitions_.resize(transitions_.size() + classes_, -1);
+                fail_.push_back(0);
+            }
+            state = transitions_[state * classes_ + byteClass_[c]];
+        }
+        patternState_.push_back(state);
+    }
+    
+    // Обход в ширину: суффиксные ссылки и достройка переходов до ДКА
+    bfsOrder_.reserve(fail_.size());
+    bfsOrder_.push_back(0);
+    for (size_t cls = 0; cls < classes_; ++cls) {
+        std::int32_t& next = transitions_[cls];
+        if (next < 0) {
+            next = 0;
+        } else {
+            fail_[next] = 0;
+            bfsOrder_.push_back(next);
+        }
+    }
+    
+    for (size_t head = 1; head < bfsOrder_.size(); ++head) {
+        std::int32_t state = bfsOrder_[head];
+        for (size_t cls = 0; cls < classes_; ++cls) {
+            std::int32_t& next = transitions_[state * classes_ + cls];
+            std::int32_t fallback = transitions_[fail_[state] * classes_ + cls];
+            if (next < 0) {
+                next = fallback;
+            } else {
+                fail_[next] = fallback;
+                bfsOrder_.push_back(next);
+            }
+        }
+    }
+}
+
+std::vector<std::uint64_t> PhraseMatcher::count(const std::string& text, int threads) const {
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    size_t length = text.length();
+    size_t states = fail_.size();
+    size_t overlap = maxLength_ - 1;
+    
+    // Посещения состояний по потокам; вхождения восстанавливаются потом
+    std::vector<std::vector<std::uint64_t>> visits(threads);
+    
+    #pragma omp parallel for num_threads(threads) schedule(static, 1)
+    for (int t = 0; t < threads; ++t) {
+        size_t from = length * t / threads;
+        size_t to = length * (t + 1) / threads;
+        size_t start = from > overlap ? from - overlap : 0;
+        
+        std::vector<std::uint64_t>& local = visits[t];
+        local.assign(states, 0);
+        
+        // Перекрытие только прогревает автомат
+        std::int32_t state = 0;
+        for (size_t i = start; i < from; ++i) {
+            state = transitions_[state * classes_ + byteClass_[bytes[i]]];
+        }
+        for (size_t i = from; i < to; ++i) {
+            state = transitions_[state * classes_ + byteClass_[bytes[i]]];
+            local[state]++;
+        }
+    }
+    
+    for (int t = 1; t < threads; ++t) {
+        for (size_t s = 0; s < states; ++s) {
+            visits[0][s] += visits[t][s];
+        }
+    }
+    
+    // Посещение состояния - вхождение всех фраз на его цепочке суффиксных
+    // ссылок: суммируем по дереву ссылок от глубоких состояний к корню
+    std::vector<std::uint64_t>& total = visits[0];
+    for (size_t k = bfsOrder_.size(); k-- > 1; ) {
+        std::int32_t state = bfsOrder_[k];
+        total[fail_[state]] += total[state];
+    }
+    
+    std::vector<std::uint64_t> counts(patterns_.size());
+    for (size_t p = 0; p < patterns_.size(); ++p) {
+        counts[p] = total[patternState_[p]];
+    }
+    return counts;
+}
+
+BookAnalyzer::AnalysisResult PhraseMatcher::countResult(const std::string& text,
+                                                        int threads) const {
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<std::uint64_t> counts = count(text, threads);
+    
+    std::map<std::string, std::uint64_t> freq;
+    std::uint64_t total = 0;
+    for (size_t p = 0; p < patterns_.size(); ++p) {
+        freq[patterns_[p]] = counts[p];
+    }
+    for (const auto& pair : freq) {
+        total += pair.second;
+    }
+    
+    std::vector<std::pair<std::string, std::uint64_t>> sorted(freq.begin(), freq.end());
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const auto& a, const auto& b) { return a.second > b.second; });
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    return BookAnalyzer::AnalysisResult{
+        freq,
+        sorted,
+        std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime),
+        threads,
+        total,
+        text.length(),
+        1.0,
+        {},
+        {}
+    };
+}
+
+std::vector<std::string> PhraseMatcher::loadPatterns(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    std::vector<std::string> patterns;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            patterns.push_back(line);
+        }
+    }
+    return patterns;
+}
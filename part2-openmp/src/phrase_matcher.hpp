@@ -0,0 +1,47 @@
+#ifndef PHRASE_MATCHER_HPP
+#define PHRASE_MATCHER_HPP
+
+#include "book_analyzer.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Подсчет вхождений множества фраз автоматом Ахо-Корасик.
+// Автомат строится по байтам UTF-8 и сразу достраивается до полного
+// ДКА: переходы лежат плотной таблицей состояния x классы байтов
+// (байты, не встречающиеся в фразах, - один общий класс), поэтому шаг
+// сканирования - одно чтение из таблицы без ветвлений по суффиксным ссылкам.
+// Учитываются все вхождения, в том числе перекрывающиеся; регистр важен
+class PhraseMatcher {
+public:
+    explicit PhraseMatcher(const std::vector<std::string>& patterns);
+    
+    // Число вхождений каждой фразы (в порядке списка). Текст делится на
+    // участки по потокам; каждый участок начинается на (максимальная длина
+    // фразы - 1) байтов раньше, а засчитываются только вхождения,
+    // заканчивающиеся внутри участка
+    std::vector<std::uint64_t> count(const std::string& text, int threads = 0) const;
+    
+    // То же в виде результата анализа: фразы вместо букв, чтобы
+    // использовать saveFrequencyCSV и printResults
+    BookAnalyzer::AnalysisResult countResult(const std::string& text, int threads = 0) const;
+    
+    // Фразы из файла: по одной в строке, пустые строки пропускаются
+    static std::vector<std::string> loadPatterns(const std::string& filename);
+    
+    size_t patternCount() const { return patterns_.size(); }
+    size_t stateCount() const { return fail_.size(); }
+    size_t classCount() const { return classes_; }
+    
+private:
+    std::vector<std::string> patterns_;
+    std::vector<std::uint16_t> byteClass_;      // 256 элементов
+    size_t classes_;
+    std::vector<std::int32_t> transitions_;     // stateCount * classes_
+    std::vector<std::int32_t> fail_;
+    std::vector<std::int32_t> bfsOrder_;
+    std::vector<std::int32_t> patternState_;
+    size_t maxLength_;
+};
+
+#endif // PHRASE_MATCHER_HPP
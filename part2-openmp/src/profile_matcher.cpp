@@ -0,0 +1,233 @@
+#include "profile_matcher.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <omp.h>
+
+namespace {
+
+constexpr int ALPHABET = BookAnalyzer::ALPHABET_SIZE;
+
+// Вектор документа для скалярного произведения со столбцом эталона:
+// оценка = offset + scale * sum x[a] * column[a]
+void prepareDocument(const BookAnalyzer::LetterHistogram& letters, ProfileMetric metric,
+                     double smoothing, double* x, double& offset, double& scale) {
+    std::uint64_t total = 0;
+    for (int a = 0; a < ALPHABET; ++a) {
+        total += letters[a];
+    }
+    
+    if (metric == ProfileMetric::Cosine) {
+        double norm = 0.0;
+        for (int a = 0; a < ALPHABET; ++a) {
+            norm += static_cast<double>(letters[a]) * static_cast<double>(letters[a]);
+        }
+        norm = std::sqrt(norm);
+        
+        // Документ без букв одинаково далек от всех эталонов
+        for (int a = 0; a < ALPHABET; ++a) {
+            x[a] = norm > 0.0 ? static_cast<double>(letters[a]) / norm : 0.0;
+        }
+        offset = 1.0;
+        scale = -1.0;
+        return;
+    }
+    
+    double denominator = static_cast<double>(total) + ALPHABET * smoothing;
+    double entropy = 0.0;
+    for (int a = 0; a < ALPHABET; ++a) {
+        double p = (static_cast<double>(letters[a]) + smoothing) / denominator;
+        if (metric == ProfileMetric::ChiSquare) {
+            // sum (p - q)^2 / q = sum p^2 / q - 1 (обе суммы вероятностей равны 1)
+            x[a] = p * p;
+        } else {
+            // sum p ln(p / q) = sum p ln p - sum p ln q
+            x[a] = -p;
+            entropy += p > 0.0 ? p * std::log(p) : 0.0;
+        }
+    }
+    offset = metric == ProfileMetric::ChiSquare ? -1.0 : entropy;
+    scale = 1.0;
+}
+
+} // namespace
+
+ProfileMatcher::ProfileMatcher(const std::vector<ReferenceProfile>& profiles, double smoothing)
+    : smoothing_(smoothing) {
+    
+    if (profiles.empty()) {
+        throw std::invalid_argument("Reference profile list is empty");
+    }
+    if (!(smoothing > 0.0)) {
+        throw std::invalid_argument("Smoothing must be positive");
+    }
+    
+    stride_ = (profiles.size() + LANES - 1) / LANES * LANES;
+    
+    // Дополнительные столбцы нулевые: их оценки считаются, но не выдаются
+    inverse_.assign(ALPHABET * stride_, 0.0);
+    logarithm_.assign(ALPHABET * stride_, 0.0);
+    unit_.assign(ALPHABET * stride_, 0.0);
+    
+    for (size_t p = 0; p < profiles.size(); ++p) {
+        const auto& letters = profiles[p].letters;
+        names_.push_back(profiles[p].name);
+        
+        std::uint64_t total = 0;
+        double norm = 0.0;
+        for (int a = 0; a < ALPHABET; ++a) {
+            total += letters[a];
+            norm += static_cast<double>(letters[a]) * static_cast<double>(letters[a]);
+        }
+        norm = std::sqrt(norm);
+        
+        double denominator = static_cast<double>(total) + ALPHABET * smoothing_;
+        for (int a = 0; a < ALPHABET; ++a) {
+            double q = (static_cast<double>(letters[a]) + smoothing_) / denominator;
+            size_t cell = a * stride_ + p;
+            inverse_[cell] = 1.0 / q;
+            logarithm_[cell] = std::log(q);
+            unit_[cell] = norm > 0.0 ? static_cast<double>(letters[a]) / norm : 0.0;
+        }
+    }
+}
+
+const std::vector<double>& ProfileMatcher::matrix(ProfileMetric metric) const {
+    switch (metric) {
+        case ProfileMetric::ChiSquare:    return inverse_;
+        case ProfileMetric::KLDivergence: return logarithm_;
+        case ProfileMetric::Cosine:       return unit_;
+    }
+    throw std::invalid_argument("Unknown profile metric");
+}
+
+std::vector<double> ProfileMatcher::score(
+    const std::vector<BookAnalyzer::LetterHistogram>& documents,
+    ProfileMetric metric,
+    int threads) const {
+    
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    const double* table = matrix(metric).data();
+    const size_t profiles = names_.size();
+    const size_t stride = stride_;
+    const long long count = static_cast<long long>(documents.size());
+    std::vector<double> scores(documents.size() * profiles);
+    
+    #pragma omp parallel num_threads(threads)
+    {
+        // Суммы по всем профилям для одного документа: строка матрицы
+        // прибавляется целиком, умноженная на частоту буквы документа
+        std::vector<double> sums(stride);
+        double x[ALPHABET];
+        
+        #pragma omp for schedule(static)
+        for (long long d = 0; d < count; ++d) {
+            double offset;
+            double scale;
+            prepareDocument(documents[d], metric, smoothing_, x, offset, scale);
+            
+            double* sum = sums.data();
+            std::fill(sum, sum + stride, 0.0);
+            for (int a = 0; a < ALPHABET; ++a) {
+                const double weight = x[a];
+                if (weight == 0.0) {
+                    continue;
+                }
+                const double* row = table + a * stride;
+                
+                #pragma omp simd
+                for (size_t p = 0; p < stride; ++p) {
+                    sum[p] += weight * row[p];
+                }
+            }
+            
+            double* out = scores.data() + d * profiles;
+            #pragma omp simd
+            for (size_t p = 0; p < profiles; ++p) {
+                out[p] = offset + scale * sum[p];
+            }
+        }
+    }
+    return scores;
+}
+
+std::vector<size_t> ProfileMatcher::bestMatch(
+    const std::vector<BookAnalyzer::LetterHistogram>& documents,
+    ProfileMetric metric,
+    int threads) const {
+    
+    std::vector<double> scores = score(documents, metric, threads);
+    const size_t profiles = names_.size();
+    
+    std::vector<size_t> best(documents.size());
+    for (size_t d = 0; d < documents.size(); ++d) {
+        const double* row = scores.data() + d * profiles;
+        best[d] = std::min_element(row, row + profiles) - row;
+    }
+    return best;
+}
+
+std::vector<ReferenceProfile> ProfileMatcher::loadProfiles(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    std::vector<ReferenceProfile> profiles;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        std::istringstream fields(line);
+        ReferenceProfile profile;
+        fields >> profile.name;
+        for (int a = 0; a < ALPHABET; ++a) {
+            fields >> profile.letters[a];
+        }
+        if (!fields) {
+            throw std::runtime_error("Malformed profile line in " + filename + ": " + line);
+        }
+        profiles.push_back(profile);
+    }
+    return profiles;
+}
+
+void ProfileMatcher::saveProfiles(const std::vector<ReferenceProfile>& profiles,
+                                  const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot create file: " + filename);
+    }
+    
+    file << "# name а б в г д е ё ж з и й к л м н о п р с т у ф х ц ч ш щ ъ ы ь э ю я\n";
+    for (const auto& profile : profiles) {
+        file << profile.name;
+        for (int a = 0; a < ALPHABET; ++a) {
+            file << ' ' << profile.letters[a];
+        }
+        file << '\n';
+    }
+}
+
+std::string ProfileMatcher::metricName(ProfileMetric metric) {
+    switch (metric) {
+        case ProfileMetric::ChiSquare:    return "chi2";
+        case ProfileMetric::KLDivergence: return "kl";
+        case ProfileMetric::Cosine:       return "cosine";
+    }
+    return "unknown";
+}
+
+ProfileMetric ProfileMatcher::parseMetric(const std::string& name) {
+    if (name == "chi2" || name == "chi-square") return ProfileMetric::ChiSquare;
+    if (name == "kl") return ProfileMetric::KLDivergence;
+    if (name == "cosine") return ProfileMetric::Cosine;
+    throw std::invalid_argument("Unknown profile metric: " + name);
+}
@@ -0,0 +1,66 @@
+#ifndef PROFILE_MATCHER_HPP
+#define PROFILE_MATCHER_HPP
+
+#include "book_analyzer.hpp"
+#include <string>
+#include <vector>
+
+// Меры различия частот букв документа и эталона (меньше - ближе)
+enum class ProfileMetric {
+    ChiSquare,      // sum (p - q)^2 / q
+    KLDivergence,   // sum p * ln(p / q)
+    Cosine          // 1 - cos(угол между векторами счетчиков)
+};
+
+// Именованный эталонный профиль (язык, автор)
+struct ReferenceProfile {
+    std::string name;
+    BookAnalyzer::LetterHistogram letters{};
+};
+
+// Сравнение документов с набором эталонов. Эталоны хранятся матрицами
+// "буква x профиль" (SoA): для каждой буквы значения всех профилей лежат
+// подряд, строка дополнена до кратного 8 числа столбцов. Каждая мера
+// сводится к скалярному произведению вектора документа на столбец
+// матрицы, поэтому внутренний цикл идет по профилям, по непрерывной
+// памяти и векторизуется (omp simd); документы делятся между потоками
+class ProfileMatcher {
+public:
+    // smoothing - добавка к каждому счетчику (Лаплас), чтобы у эталона
+    // не было нулевых вероятностей для хи-квадрат и KL
+    explicit ProfileMatcher(const std::vector<ReferenceProfile>& profiles,
+                            double smoothing = 0.5);
+    
+    // Оценки documents x profiles по строкам документов
+    std::vector<double> score(const std::vector<BookAnalyzer::LetterHistogram>& documents,
+                              ProfileMetric metric, int threads = 0) const;
+    
+    // Индекс ближайшего эталона для каждого документа
+    std::vector<size_t> bestMatch(const std::vector<BookAnalyzer::LetterHistogram>& documents,
+                                  ProfileMetric metric, int threads = 0) const;
+    
+    size_t profileCount() const { return names_.size(); }
+    const std::string& profileName(size_t index) const { return names_[index]; }
+    
+    // Файл эталонов: строка "имя c0 ... c32", строки с # пропускаются
+    static std::vector<ReferenceProfile> loadProfiles(const std::string& filename);
+    static void saveProfiles(const std::vector<ReferenceProfile>& profiles,
+                             const std::string& filename);
+    
+    static std::string metricName(ProfileMetric metric);
+    static ProfileMetric parseMetric(const std::string& name);
+    
+private:
+    static constexpr size_t LANES = 8;
+    
+    const std::vector<double>& matrix(ProfileMetric metric) const;
+    
+    std::vector<std::string> names_;
+    double smoothing_;
+    size_t stride_;                     // Столбцов в строке матрицы
+    std::vector<double> inverse_;       // 1 / q (хи-квадрат)
+    std::vector<double> logarithm_;     // ln q (KL)
+    std::vector<double> unit_;          // Счетчики / норма (косинус)
+};
+
+#endif // PROFILE_MATCHER_HPP
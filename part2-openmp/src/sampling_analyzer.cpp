@@ -0,0 +1,250 @@
+#include "sampling_analyzer.hpp"
+#include "text_encoding.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <omp.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Чтение ровно count байтов (или до конца файла)
+size_t readAt(int fd, char* buffer, size_t count, std::uint64_t offset) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t n = ::pread(fd, buffer + done, count - done, static_cast<off_t>(offset + done));
+        if (n < 0) {
+            throw std::runtime_error("Cannot read sample block");
+        }
+        if (n == 0) {
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return done;
+}
+
+// Суммы по блокам для оценки отношения и его дисперсии
+struct ClusterSums {
+    double n = 0.0;     // Σ n_i (буквы в блоке)
+    double nn = 0.0;    // Σ n_i²
+    std::vector<double> x;   // Σ x_ai
+    std::vector<double> xx;  // Σ x_ai²
+    std::vector<double> xn;  // Σ x_ai n_i
+    
+    ClusterSums()
+        : x(BookAnalyzer::ALPHABET_SIZE, 0.0),
+          xx(BookAnalyzer::ALPHABET_SIZE, 0.0),
+          xn(BookAnalyzer::ALPHABET_SIZE, 0.0) {}
+};
+
+} // namespace
+
+double SamplingResult::maxHalfWidth() const {
+    return halfWidth.empty() ? 0.0 : *std::max_element(halfWidth.begin(), halfWidth.end());
+}
+
+SamplingResult SamplingAnalyzer::analyzeFile(const std::string& filename,
+                                             const SamplingOptions& options) {
+    if (options.blockSize < 2) {
+        throw std::invalid_argument("Sample block must be at least 2 bytes");
+    }
+    
+    auto startTime = std::chrono::high_resolution_clock::now();
+    int threads = options.threads > 0 ? options.threads : omp_get_max_threads();
+    const int A = BookAnalyzer::ALPHABET_SIZE;
+    
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat file: " + filename);
+    }
+    
+    SamplingResult result;
+    result.totalBytes = static_cast<std::uint64_t>(st.st_size);
+    result.totalBlocks = static_cast<size_t>(
+        (result.totalBytes + options.blockSize - 1) / options.blockSize);
+    result.share.assign(A, 0.0);
+    result.halfWidth.assign(A, 0.0);
+    
+    // Кодировка - по первому блоку
+    TextEncoding encoding = TextEncoding::UTF8;
+    {
+        std::string head(std::min<std::uint64_t>(result.totalBytes, options.blockSize), '\0');
+        head.resize(readAt(fd, &head[0], head.size(), 0));
+        encoding = TextDecoder::detect(head);
+    }
+    result.encoding = TextDecoder::name(encoding);
+    const TextDecoder::ByteTable* table =
+        encoding == TextEncoding::UTF8 ? nullptr : &TextDecoder::letterTable(encoding);
+    
+    // Случайный порядок блоков без повторов
+    std::vector<size_t> order(result.totalBlocks);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937_64 rng(options.seed);
+    std::shuffle(order.begin(), order.end(), rng);
+    
+    size_t limit = options.maxBlocks > 0 ? std::min(options.maxBlocks, result.totalBlocks)
+                                         : result.totalBlocks;
+    size_t batch = static_cast<size_t>(threads) * 4;
+    
+    ClusterSums sums;
+    std::vector<std::uint64_t> blockCounts;
+    std::vector<std::uint64_t> blockBytes;
+    std::string error;
+    
+    while (result.blocksRead < limit) {
+        size_t first = result.blocksRead;
+        size_t count = std::min(limit - first,
+                                first == 0 ? std::max(batch, options.minBlocks) : batch);
+        blockCounts.assign(count * A, 0);
+        blockBytes.assign(count, 0);
+        
+        #pragma omp parallel num_threads(threads)
+        {
+            // Лишний байт: буква, начатая в последнем байте блока, - его
+            std::vector<char> buffer(options.blockSize + 1);
+            
+            #pragma omp for schedule(dynamic, 1)
+            for (size_t k = 0; k < count; ++k) {
+                std::uint64_t offset = static_cast<std::uint64_t>(order[first + k]) * options.blockSize;
+                size_t got = 0;
+                try {
+                    got = readAt(fd, buffer.data(), buffer.size(), offset);
+                } catch (const std::exception& e) {
+                    #pragma omp critical
+                    error = e.what();
+                    continue;
+                }
+                
+                size_t own = std::min(got, options.blockSize);
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(buffer.data());
+                std::uint64_t* counts = blockCounts.data() + k * A;
+                
+                if (table) {
+                    for (size_t i = 0; i < own; ++i) {
+                        int index = (*table)[bytes[i]];
+                        if (index >= 0) counts[index]++;
+                    }
+                } else {
+                    // Начало блока посреди символа пропускается: продолжения
+                    // UTF-8 не бывают первым байтом буквы
+                    for (size_t i = 0; i < own; ++i) {
+                        int index = BookAnalyzer::letterIndexUTF8(bytes, i, got);
+                        if (index >= 0) {
+                            counts[index]++;
+                            i++;
+                        }
+                    }
+                }
+                blockBytes[k] = own;
+            }
+        }
+        
+        if (!error.empty()) {
+            ::close(fd);
+            throw std::runtime_error(error + ": " + filename);
+        }
+        
+        // Накопление сумм по блокам пачки
+        for (size_t k = 0; k < count; ++k) {
+            const std::uint64_t* counts = blockCounts.data() + k * A;
+            double n = 0.0;
+            for (int a = 0; a < A; ++a) {
+                n += counts[a];
+            }
+            sums.n += n;
+            sums.nn += n * n;
+            for (int a = 0; a < A; ++a) {
+                double x = static_cast<double>(counts[a]);
+                result.sampled[a] += counts[a];
+                sums.x[a] += x;
+                sums.xx[a] += x * x;
+                sums.xn[a] += x * n;
+            }
+            result.bytesRead += blockBytes[k];
+        }
+        result.blocksRead += count;
+        
+        // Интервалы для отношения: Var ≈ (1 - f) s² / (m n̄²),
+        // s² = Σ(x_i - p n_i)² / (m - 1)
+        double m = static_cast<double>(result.blocksRead);
+        double fpc = 1.0 - m / static_cast<double>(result.totalBlocks);
+        double meanLetters = sums.n / m;
+        for (int a = 0; a < A; ++a) {
+            double p = sums.n > 0.0 ? sums.x[a] / sums.n : 0.0;
+            result.share[a] = p;
+            if (m < 2.0 || meanLetters <= 0.0) {
+                result.halfWidth[a] = fpc > 0.0 ? 1.0 : 0.0;
+                continue;
+            }
+            double s2 = (sums.xx[a] - 2.0 * p * sums.xn[a] + p * p * sums.nn) / (m - 1.0);
+            double variance = std::max(0.0, fpc) * std::max(0.0, s2) / (m * meanLetters * meanLetters);
+            result.halfWidth[a] = options.z * std::sqrt(variance);
+        }
+        result.estimatedLetters = meanLetters * result.totalBlocks;
+        
+        if (result.blocksRead >= options.minBlocks &&
+            result.maxHalfWidth() <= options.targetError &&
+            result.blocksRead < result.totalBlocks) {
+            result.converged = true;
+            break;
+        }
+    }
+    
+    ::close(fd);
+    
+    // Прочитан весь файл - оценка точная
+    if (result.blocksRead == result.totalBlocks) {
+        result.converged = true;
+    }
+    
+    result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime
+    );
+    return result;
+}
+
+void SamplingAnalyzer::printResults(const SamplingResult& result) {
+    std::cout << "SAMPLING ANALYSIS RESULTS" << std::endl;
+    
+    std::cout << "\nSampling Statistics:" << std::endl;
+    std::cout << " Encoding: " << result.encoding << std::endl;
+    std::cout << " Blocks read: " << result.blocksRead << " of " << result.totalBlocks << std::endl;
+    std::cout << " Bytes read: " << result.bytesRead << " of " << result.totalBytes
+              << " (" << std::fixed << std::setprecision(2)
+              << (result.totalBytes > 0 ? result.bytesRead * 100.0 / result.totalBytes : 0.0)
+              << "%)" << std::endl;
+    std::cout << " Processing time: " << result.processingTime.count() / 1000.0 << " ms" << std::endl;
+    std::cout << " Estimated Russian letters: " << std::setprecision(0)
+              << result.estimatedLetters << std::endl;
+    std::cout << " Target precision reached: " << (result.converged ? "yes" : "no")
+              << " (max half-width " << std::setprecision(3)
+              << result.maxHalfWidth() * 100.0 << "%)" << std::endl;
+    
+    // Буквы по убыванию оценки доли
+    std::vector<int> letters(BookAnalyzer::ALPHABET_SIZE);
+    std::iota(letters.begin(), letters.end(), 0);
+    std::sort(letters.begin(), letters.end(),
+              [&](int a, int b) { return result.share[a] > result.share[b]; });
+    
+    std::cout << "\nEstimated Letter Shares (share ± half-width):" << std::endl;
+    for (size_t i = 0; i < letters.size(); ++i) {
+        int a = letters[i];
+        std::cout << "   " << std::setw(2) << (i + 1) << ". "
+                  << BookAnalyzer::letterFromIndex(a) << " : "
+                  << std::setprecision(3) << std::setw(6) << result.share[a] * 100.0
+                  << "% ± " << std::setw(5) << result.halfWidth[a] * 100.0 << "%" << std::endl;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef SAMPLING_ANALYZER_HPP
+#define SAMPLING_ANALYZER_HPP
+
+#include "book_analyzer.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Параметры выборочной оценки
+struct SamplingOptions {
+    size_t blockSize = 64 * 1024;   // Размер читаемого блока в байтах
+    double targetError = 0.001;     // Допустимая полуширина интервала доли
+    double z = 1.96;                // Квантиль нормального распределения (95%)
+    size_t minBlocks = 32;          // Не останавливаться раньше
+    size_t maxBlocks = 0;           // 0 - без ограничения
+    unsigned seed = 2024;
+    int threads = 0;
+};
+
+// Результат: доли букв с доверительными интервалами
+struct SamplingResult {
+    BookAnalyzer::LetterHistogram sampled{};     // Буквы в прочитанных блоках
+    std::vector<double> share;                   // Оценка доли каждой буквы
+    std::vector<double> halfWidth;               // Полуширина интервала
+    double estimatedLetters = 0.0;               // Оценка числа букв в файле
+    size_t blocksRead = 0;
+    size_t totalBlocks = 0;
+    std::uint64_t bytesRead = 0;
+    std::uint64_t totalBytes = 0;
+    bool converged = false;                      // Точность достигнута до конца файла
+    std::string encoding;
+    std::chrono::microseconds processingTime{0};
+    
+    double maxHalfWidth() const;
+};
+
+// Оценка частот по случайным блокам файла без чтения его целиком.
+// Блоки выбираются без повторов и читаются pread пачками параллельно;
+// буква принадлежит блоку своего первого байта, поэтому блоки делят
+// буквы файла без пересечений. Доля буквы - отношение сумм по блокам,
+// дисперсия - по формуле для кластерной выборки с поправкой на конечность
+class SamplingAnalyzer {
+public:
+    static SamplingResult analyzeFile(const std::string& filename,
+                                      const SamplingOptions& options = SamplingOptions());
+    
+    static void printResults(const SamplingResult& result);
+};
+
+#endif // SAMPLING_ANALYZER_HPP
@@ -0,0 +1,202 @@
+#include "sliding_window.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <omp.h>
+
+namespace {
+
+const size_t EXTRACT_BLOCK = 64 * 1024;
+
+// Заголовок двоичного ряда
+struct SeriesHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t window;
+    std::uint64_t step;
+    std::uint64_t windows;
+    std::uint64_t alphabet;
+};
+
+} // namespace
+
+void SlidingWindowAnalyzer::extractLetters(const std::string& text, int threads,
+                                           std::vector<std::uint8_t>& letters,
+                                           std::vector<size_t>& offsets) {
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    size_t length = text.length();
+    size_t blocks = (length + EXTRACT_BLOCK - 1) / EXTRACT_BLOCK;
+    
+    // Буквы каждого блока собираются отдельно, затем склеиваются по порядку
+    std::vector<std::vector<std::uint8_t>> blockLetters(blocks);
+    std::vector<std::vector<size_t>> blockOffsets(blocks);
+    
+    #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+    for (size_t block = 0; block < blocks; ++block) {
+        size_t from = block * EXTRACT_BLOCK;
+        size_t to = std::min(length, from + EXTRACT_BLOCK);
+        
+        // Буква на границе принадлежит блоку своего первого байта
+        for (size_t i = from; i < to; ++i) {
+            int index = BookAnalyzer::letterIndexUTF8(bytes, i, length);
+            if (index >= 0) {
+                blockLetters[block].push_back(static_cast<std::uint8_t>(index));
+                blockOffsets[block].push_back(i);
+                i++;
+            }
+        }
+    }
+    
+    std::vector<size_t> start(blocks + 1, 0);
+    for (size_t block = 0; block < blocks; ++block) {
+        start[block + 1] = start[block] + blockLetters[block].size();
+    }
+    
+    letters.resize(start[blocks]);
+    offsets.resize(start[blocks]);
+    
+    #pragma omp parallel for num_threads(threads)
+    for (size_t block = 0; block < blocks; ++block) {
+        std::copy(blockLetters[block].begin(), blockLetters[block].end(),
+                  letters.begin() + start[block]);
+        std::copy(blockOffsets[block].begin(), blockOffsets[block].end(),
+                  offsets.begin() + start[block]);
+    }
+}
+
+WindowSeries SlidingWindowAnalyzer::compute(const std::string& text, size_t window,
+                                            size_t step, int threads) {
+    if (window == 0 || step == 0) {
+        throw std::invalid_argument("Window and step must be positive");
+    }
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    std::vector<std::uint8_t> letters;
+    std::vector<size_t> offsets;
+    extractLetters(text, threads, letters, offsets);
+    
+    const size_t A = BookAnalyzer::ALPHABET_SIZE;
+    
+    WindowSeries series;
+    series.window = window;
+    series.step = step;
+    series.totalLetters = letters.size();
+    
+    size_t windows = letters.size() < window ? 0 : (letters.size() - window) / step + 1;
+    series.startByte.resize(windows);
+    series.endByte.resize(windows);
+    series.counts.assign(windows * A, 0);
+    
+    if (windows == 0) {
+        return series;
+    }
+    
+    // Ряд делится на непрерывные сегменты окон, по одному на поток
+    int segments = static_cast<int>(std::min<size_t>(windows, threads));
+    
+    #pragma omp parallel for num_threads(threads) schedule(static, 1)
+    for (int segment = 0; segment < segments; ++segment) {
+        size_t first = windows * segment / segments;
+        size_t last = windows * (segment + 1) / segments;
+        
+        // Прогрев: первое окно сегмента считается целиком
+        BookAnalyzer::LetterHistogram histogram{};
+        size_t begin = first * step;
+        for (size_t k = begin; k < begin + window; ++k) {
+            histogram[letters[k]]++;
+        }
+        
+        for (size_t w = first; w < last; ++w) {
+            if (w > first) {
+                size_t previous = (w - 1) * step;
+                begin = w * step;
+                
+                if (step >= window) {
+                    // Окна не пересекаются: пересчет дешевле сдвига
+                    histogram.fill(0);
+                    for (size_t k = begin; k < begin + window; ++k) {
+                        histogram[letters[k]]++;
+                    }
+                } else {
+                    // Уходят буквы [previous, begin), входят [previous + window, begin + window)
+                    for (size_t k = previous; k < begin; ++k) {
+                        histogram[letters[k]]--;
+                    }
+                    for (size_t k = previous + window; k < begin + window; ++k) {
+                        histogram[letters[k]]++;
+                    }
+                }
+            }
+            
+            std::copy(histogram.begin(), histogram.end(), series.counts.begin() + w * A);
+            series.startByte[w] = offsets[begin];
+            series.endByte[w] = offsets[begin + window - 1] + 2;
+        }
+    }
+    
+    return series;
+}
+
+void SlidingWindowAnalyzer::saveCSV(const WindowSeries& series, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    file << "Window,StartLetter,StartByte,EndByte";
+    for (int a = 0; a < BookAnalyzer::ALPHABET_SIZE; ++a) {
+        file << "," << BookAnalyzer::letterFromIndex(a);
+    }
+    file << "\n";
+    
+    file << std::fixed << std::setprecision(6);
+    for (size_t w = 0; w < series.windows(); ++w) {
+        file << w << "," << w * series.step << ","
+             << series.startByte[w] << "," << series.endByte[w];
+        
+        const std::uint64_t* histogram = series.histogram(w);
+        for (int a = 0; a < BookAnalyzer::ALPHABET_SIZE; ++a) {
+            file << "," << static_cast<double>(histogram[a]) / series.window;
+        }
+        file << "\n";
+    }
+    
+    std::cout << "Window series saved to: " << filename << std::endl;
+}
+
+void SlidingWindowAnalyzer::saveBinary(const WindowSeries& series, const std::string& filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    SeriesHeader header{};
+    std::memcpy(header.magic, "FWIN", 4);
+    header.version = 1;
+    header.window = series.window;
+    header.step = series.step;
+    header.windows = series.windows();
+    header.alphabet = BookAnalyzer::ALPHABET_SIZE;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    for (size_t w = 0; w < series.windows(); ++w) {
+        std::uint64_t bounds[2] = {series.startByte[w], series.endByte[w]};
+        file.write(reinterpret_cast<const char*>(bounds), sizeof(bounds));
+        file.write(reinterpret_cast<const char*>(series.histogram(w)),
+                   BookAnalyzer::ALPHABET_SIZE * sizeof(std::uint64_t));
+    }
+    
+    if (!file) {
+        throw std::runtime_error("Cannot write file: " + filename);
+    }
+    std::cout << "Window series saved to: " << filename << std::endl;
+}
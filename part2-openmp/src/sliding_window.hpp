@@ -0,0 +1,45 @@
+#ifndef SLIDING_WINDOW_HPP
+#define SLIDING_WINDOW_HPP
+
+#include "book_analyzer.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Временной ряд частот букв в скользящем окне. Окно и шаг задаются
+// в буквах: окно i покрывает буквы [i * step, i * step + window)
+struct WindowSeries {
+    size_t window = 0;
+    size_t step = 0;
+    size_t totalLetters = 0;
+    std::vector<size_t> startByte;       // Смещение первой буквы окна
+    std::vector<size_t> endByte;         // Смещение за последней буквой
+    std::vector<std::uint64_t> counts;   // windows() * ALPHABET_SIZE
+    
+    size_t windows() const { return startByte.size(); }
+    const std::uint64_t* histogram(size_t index) const {
+        return counts.data() + index * BookAnalyzer::ALPHABET_SIZE;
+    }
+};
+
+class SlidingWindowAnalyzer {
+public:
+    // Окна считаются инкрементально: при сдвиге вычитаются выходящие
+    // буквы и добавляются входящие. Ряд делится на сегменты по потокам,
+    // первое окно сегмента считается целиком (прогрев)
+    static WindowSeries compute(const std::string& text, size_t window, size_t step,
+                                int threads = 0);
+    
+    // Последовательность индексов букв текста и их смещений в байтах
+    static void extractLetters(const std::string& text, int threads,
+                               std::vector<std::uint8_t>& letters,
+                               std::vector<size_t>& offsets);
+    
+    // CSV: одна строка на окно, доли букв по столбцам
+    static void saveCSV(const WindowSeries& series, const std::string& filename);
+    
+    // Двоичный файл: заголовок, затем по окну смещения и счетчики (uint64)
+    static void saveBinary(const WindowSeries& series, const std::string& filename);
+};
+
+#endif // SLIDING_WINDOW_HPP
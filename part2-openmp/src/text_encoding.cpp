@@ -0,0 +1,249 @@
+#include "text_encoding.hpp"
+#include "letter_kernel.hpp"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <omp.h>
+
+namespace {
+
+// Индекс буквы без ё (0-31) -> индекс алфавита (ё - 6)
+constexpr std::int8_t skipYo(int k) {
+    return static_cast<std::int8_t>(k < 6 ? k : k + 1);
+}
+
+constexpr TextDecoder::ByteTable makeCp1251() {
+    TextDecoder::ByteTable table{};
+    for (int b = 0; b < 256; ++b) {
+        table[b] = -1;
+    }
+    // А-Я 0xC0-0xDF, а-я 0xE0-0xFF, Ё 0xA8, ё 0xB8
+    for (int k = 0; k < 32; ++k) {
+        table[0xC0 + k] = skipYo(k);
+        table[0xE0 + k] = skipYo(k);
+    }
+    table[0xA8] = 6;
+    table[0xB8] = 6;
+    return table;
+}
+
+constexpr TextDecoder::ByteTable makeKoi8r() {
+    TextDecoder::ByteTable table{};
+    for (int b = 0; b < 256; ++b) {
+        table[b] = -1;
+    }
+    // Порядок букв KOI8-R (юабцдефгхийклмнопярстужвьызшэщчъ):
+    // строчные 0xC0-0xDF, заглавные 0xE0-0xFF, ё 0xA3, Ё 0xB3
+    constexpr std::int8_t order[32] = {
+        31, 0, 1, 23, 4, 5, 21, 3, 22, 9, 10, 11, 12, 13, 14, 15,
+        16, 32, 17, 18, 19, 20, 7, 2, 29, 28, 8, 25, 30, 26, 24, 27
+    };
+    for (int k = 0; k < 32; ++k) {
+        table[0xC0 + k] = order[k];
+        table[0xE0 + k] = order[k];
+    }
+    table[0xA3] = 6;
+    table[0xB3] = 6;
+    return table;
+}
+
+constexpr TextDecoder::ByteTable CP1251_TABLE = makeCp1251();
+constexpr TextDecoder::ByteTable KOI8R_TABLE = makeKoi8r();
+
+// Для определения кодировки достаточно начала текста
+const size_t DETECT_SAMPLE = 1 << 20;
+
+// Частые строчные буквы: а е и н о т
+bool isFrequentLetter(int index) {
+    return index == 0 || index == 5 || index == 9 || index == 14 ||
+           index == 15 || index == 19;
+}
+
+} // namespace
+
+TextEncoding TextDecoder::detect(const std::string& text) {
+    return detect(text.data(), text.length());
+}
+
+TextEncoding TextDecoder::detect(const char* data, size_t size) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t length = std::min(size, DETECT_SAMPLE);
+    
+    // Проверка UTF-8: ведущий байт и нужное число байтов продолжения.
+    // Последовательность, обрезанная концом выборки, ошибкой не считается
+    size_t highBytes = 0;
+    size_t invalid = 0;
+    for (size_t i = 0; i < length; ) {
+        unsigned char c = bytes[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+        highBytes++;
+        
+        int continuation = c >= 0xC2 && c <= 0xDF ? 1 :
+                           c >= 0xE0 && c <= 0xEF ? 2 :
+                           c >= 0xF0 && c <= 0xF4 ? 3 : -1;
+        if (continuation < 0) {
+            invalid++;
+            i++;
+            continue;
+        }
+        
+        size_t j = 1;
+        while (j <= static_cast<size_t>(continuation) && i + j < length &&
+               (bytes[i + j] & 0xC0) == 0x80) {
+            j++;
+        }
+        if (j <= static_cast<size_t>(continuation) && i + j < length) {
+            invalid++;
+        }
+        i += j;
+    }
+    
+    if (highBytes == 0 || invalid * 100 <= highBytes) {
+        return TextEncoding::UTF8;
+    }
+    
+    // Строчные буквы встречаются чаще заглавных: в CP1251 они лежат
+    // в 0xE0-0xFF, в KOI8-R - в 0xC0-0xDF
+    size_t cp1251Score = 0;
+    size_t koi8Score = 0;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = bytes[i];
+        if (c >= 0xE0 && isFrequentLetter(CP1251_TABLE[c])) {
+            cp1251Score++;
+        }
+        if (c >= 0xC0 && c <= 0xDF && isFrequentLetter(KOI8R_TABLE[c])) {
+            koi8Score++;
+        }
+    }
+    
+    return koi8Score > cp1251Score ? TextEncoding::KOI8R : TextEncoding::CP1251;
+}
+
+const TextDecoder::ByteTable& TextDecoder::letterTable(TextEncoding encoding) {
+    switch (encoding) {
+        case TextEncoding::CP1251:
+            return CP1251_TABLE;
+        case TextEncoding::KOI8R:
+            return KOI8R_TABLE;
+        default:
+            throw std::invalid_argument("UTF-8 has no single-byte letter table");
+    }
+}
+
+BookAnalyzer::LetterHistogram TextDecoder::countLetters(const std::string& text,
+                                                        TextEncoding encoding,
+                                                        int threads) {
+    return countLetters(text.data(), text.length(), encoding, threads);
+}
+
+BookAnalyzer::LetterHistogram TextDecoder::countLetters(const char* data, size_t length,
+                                                        TextEncoding encoding,
+                                                        int threads) {
+    if (encoding == TextEncoding::UTF8) {
+        return BookAnalyzer::countLetters(data, length, BookAnalyzer::TuningConfig{threads});
+    }
+    
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    const ByteTable& table = letterTable(encoding);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    
+    // Гистограмма байтов не зависит от кодировки и не требует ветвлений
+    std::array<std::uint64_t, 256> byteCounts{};
+    
+    #pragma omp parallel num_threads(threads)
+    {
+        std::array<std::uint64_t, 256> local{};
+        
+        #pragma omp for schedule(static)
+        for (size_t i = 0; i < length; ++i) {
+            local[bytes[i]]++;
+        }
+        
+        #pragma omp critical
+        for (int b = 0; b < 256; ++b) {
+            byteCounts[b] += local[b];
+        }
+    }
+    
+    BookAnalyzer::LetterHistogram histogram{};
+    for (int b = 0; b < 256; ++b) {
+        if (table[b] >= 0) {
+            histogram[table[b]] += byteCounts[b];
+        }
+    }
+    return histogram;
+}
+
+void TextDecoder::accumulate(const char* data, size_t length, size_t available,
+                             TextEncoding encoding, BookAnalyzer::LetterHistogram& histogram) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    
+    if (encoding == TextEncoding::UTF8) {
+        LetterKernel::Counters<std::uint64_t> counters{};
+        LetterKernel::count<LetterKernel::Russian, LetterKernel::FoldCase>(
+            bytes, 0, length, available, counters);
+        for (int a = 0; a < BookAnalyzer::ALPHABET_SIZE; ++a) {
+            histogram[a] += counters[a];
+        }
+        return;
+    }
+    
+    const ByteTable& table = letterTable(encoding);
+    for (size_t i = 0; i < length; ++i) {
+        int letter = table[bytes[i]];
+        if (letter >= 0) {
+            histogram[letter]++;
+        }
+    }
+}
+
+BookAnalyzer::AnalysisResult TextDecoder::analyze(const std::string& text,
+                                                  TextEncoding encoding,
+                                                  int threads) {
+    if (encoding == TextEncoding::UTF8) {
+        BookAnalyzer analyzer;
+        return analyzer.analyzeText(text, threads);
+    }
+    
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    auto startTime = std::chrono::high_resolution_clock::now();
+    auto result = BookAnalyzer::resultFromHistogram(countLetters(text, encoding, threads),
+                                                    text.length());
+    result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime
+    );
+    result.threadsUsed = threads;
+    return result;
+}
+
+std::string TextDecoder::name(TextEncoding encoding) {
+    switch (encoding) {
+        case TextEncoding::CP1251:
+            return "cp1251";
+        case TextEncoding::KOI8R:
+            return "koi8-r";
+        default:
+            return "utf-8";
+    }
+}
+
+TextEncoding TextDecoder::parse(const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    
+    if (lower == "utf-8" || lower == "utf8") return TextEncoding::UTF8;
+    if (lower == "cp1251" || lower == "windows-1251") return TextEncoding::CP1251;
+    if (lower == "koi8-r" || lower == "koi8r") return TextEncoding::KOI8R;
+    
+    throw std::invalid_argument("Unknown encoding: " + name);
+}
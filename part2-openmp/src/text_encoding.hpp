@@ -0,0 +1,55 @@
+#ifndef TEXT_ENCODING_HPP
+#define TEXT_ENCODING_HPP
+
+#include "book_analyzer.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Кодировки русского текста
+enum class TextEncoding {
+    UTF8,
+    CP1251,
+    KOI8R
+};
+
+// Однобайтовые кириллические кодировки: таблица на 256 байтов переводит
+// байт в индекс буквы алфавита (те же слоты, что и у UTF-8)
+class TextDecoder {
+public:
+    using ByteTable = std::array<std::int8_t, 256>;
+    
+    // Определение кодировки по началу текста: корректный UTF-8 с русскими
+    // буквами или ASCII - UTF-8; иначе побеждает кодировка, в которой
+    // больше байтов оказываются частыми строчными буквами
+    static TextEncoding detect(const std::string& text);
+    static TextEncoding detect(const char* data, size_t length);
+    
+    // Таблица байт -> индекс буквы (-1 - не буква); для UTF-8 - исключение
+    static const ByteTable& letterTable(TextEncoding encoding);
+    
+    // Подсчет букв. Однобайтовый путь сначала строит гистограмму байтов
+    // (по потоку), затем сворачивает ее таблицей
+    static BookAnalyzer::LetterHistogram countLetters(const std::string& text,
+                                                      TextEncoding encoding,
+                                                      int threads = 0);
+    static BookAnalyzer::LetterHistogram countLetters(const char* data, size_t length,
+                                                      TextEncoding encoding,
+                                                      int threads = 0);
+    
+    // Последовательный подсчет букв, начинающихся в первых length байтах,
+    // с добавлением в histogram. available >= length - сколько байтов можно
+    // прочитать (в UTF-8 буква в последнем байте дочитывается за length)
+    static void accumulate(const char* data, size_t length, size_t available,
+                           TextEncoding encoding, BookAnalyzer::LetterHistogram& histogram);
+    
+    // Анализ текста в заданной кодировке (результат как у analyzeText)
+    static BookAnalyzer::AnalysisResult analyze(const std::string& text,
+                                                TextEncoding encoding,
+                                                int threads = 0);
+    
+    static std::string name(TextEncoding encoding);
+    static TextEncoding parse(const std::string& name);
+};
+
+#endif // TEXT_ENCODING_HPP
@@ -0,0 +1,448 @@
+#include "word_sketch.hpp"
+#include "book_analyzer.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <omp.h>
+
+CountMinSketch::CountMinSketch(size_t width, int depth)
+    : width_(width), mask_(width - 1), depth_(depth),
+      table_(width * static_cast<size_t>(depth), 0) {
+    
+    if (width == 0 || (width & (width - 1)) != 0 || depth < 1) {
+        throw std::invalid_argument("Count-Min width must be a power of two");
+    }
+}
+
+// Строки используют хеши h1 + i * h2 (двойное хеширование)
+void CountMinSketch::add(std::uint64_t hash, std::uint64_t count) {
+    std::uint64_t h1 = hash & 0xFFFFFFFFu;
+    std::uint64_t h2 = (hash >> 32) | 1;
+    for (int row = 0; row < depth_; ++row) {
+        table_[row * width_ + ((h1 + row * h2) & mask_)] += count;
+    }
+}
+
+std::uint64_t CountMinSketch::estimate(std::uint64_t hash) const {
+    std::uint64_t h1 = hash & 0xFFFFFFFFu;
+    std::uint64_t h2 = (hash >> 32) | 1;
+    std::uint64_t result = UINT64_MAX;
+    for (int row = 0; row < depth_; ++row) {
+        result = std::min(result, table_[row * width_ + ((h1 + row * h2) & mask_)]);
+    }
+    return result;
+}
+
+void CountMinSketch::merge(const CountMinSketch& other) {
+    if (other.width_ != width_ || other.depth_ != depth_) {
+        throw std::invalid_argument("Cannot merge Count-Min sketches of different shape");
+    }
+    for (size_t i = 0; i < table_.size(); ++i) {
+        table_[i] += other.table_[i];
+    }
+}
+
+HyperLogLog::HyperLogLog(int precision)
+    : precision_(precision), registers_(size_t(1) << precision, 0) {
+    
+    if (precision < 4 || precision > 18) {
+        throw std::invalid_argument("HyperLogLog precision must be in [4, 18]");
+    }
+}
+
+void HyperLogLog::add(std::uint64_t hash) {
+    size_t index = hash >> (64 - precision_);
+    std::uint64_t rest = hash << precision_;
+    
+    // Позиция первой единицы в оставшихся битах
+    std::uint8_t rank = rest == 0 ? static_cast<std::uint8_t>(64 - precision_ + 1)
+                                  : static_cast<std::uint8_t>(__builtin_clzll(rest) + 1);
+    registers_[index] = std::max(registers_[index], rank);
+}
+
+double HyperLogLog::estimate() const {
+    double m = static_cast<double>(registers_.size());
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (std::uint8_t r : registers_) {
+        sum += std::ldexp(1.0, -r);
+        zeros += r == 0;
+    }
+    
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    
+    // Малые мощности: линейный счет по пустым регистрам
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * std::log(m / static_cast<double>(zeros));
+    }
+    return estimate;
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.precision_ != precision_) {
+        throw std::invalid_argument("Cannot merge HyperLogLog of different precision");
+    }
+    for (size_t i = 0; i < registers_.size(); ++i) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+}
+
+// FNV-1a с перемешиванием splitmix64: старшие биты нужны HyperLogLog
+std::uint64_t WordSketchAnalyzer::hashWord(const std::string& word) {
+    std::uint64_t hash = 1469598103934665603ull;
+    for (unsigned char c : word) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+namespace {
+
+// Границы участков - на однобайтовых разделителях, чтобы слово
+// целиком попадало в один участок
+std::vector<size_t> wordChunkBounds(const unsigned char* bytes, size_t length, size_t chunks) {
+    std::vector<size_t> bounds(chunks + 1, length);
+    bounds[0] = 0;
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t pos = std::max(bounds[c - 1], length * c / chunks);
+        while (pos < length && (bytes[pos] >= 0x80 || std::isalnum(bytes[pos]))) {
+            pos++;
+        }
+        bounds[c] = pos;
+    }
+    return bounds;
+}
+
+// Вызов callback для каждого слова [from, to) в нижнем регистре
+template <typename Callback>
+void forEachWord(const unsigned char* bytes, size_t from, size_t to, size_t length,
+                 Callback&& callback) {
+    static const std::vector<std::string> lower = [] {
+        std::vector<std::string> letters;
+        for (int a = 0; a < BookAnalyzer::ALPHABET_SIZE; ++a) {
+            letters.push_back(BookAnalyzer::letterFromIndex(a));
+        }
+        return letters;
+    }();
+    
+    std::string word;
+    for (size_t i = from; i < to; ) {
+        int letter = BookAnalyzer::letterIndexUTF8(bytes, i, length);
+        if (letter >= 0) {
+            word += lower[letter];
+            i += 2;
+            continue;
+        }
+        if (bytes[i] < 0x80 && std::isalnum(bytes[i])) {
+            word += static_cast<char>(std::tolower(bytes[i]));
+            i++;
+            continue;
+        }
+        if (!word.empty()) {
+            callback(word);
+            word.clear();
+        }
+        i++;
+    }
+    if (!word.empty()) {
+        callback(word);
+    }
+}
+
+// Кандидаты в частые слова потока: не больше capacity записей, при
+// переполнении вытесняется слово с наименьшей оценкой
+class TopCandidates {
+public:
+    explicit TopCandidates(size_t capacity) : capacity_(capacity), minValue_(0) {}
+    
+    void offer(const std::string& word, std::uint64_t estimate) {
+        auto it = entries_.find(word);
+        if (it != entries_.end()) {
+            it->second = estimate;
+            return;
+        }
+        if (entries_.size() < capacity_) {
+            entries_.emplace(word, estimate);
+            minValue_ = std::min(minValue_, estimate);
+            return;
+        }
+        
+        // Сохраненный минимум мог устареть только вниз, поэтому быстрый
+        // отказ корректен; вытеснение уточняет минимум проходом
+        if (estimate <= minValue_) {
+            return;
+        }
+        auto victim = std::min_element(entries_.begin(), entries_.end(),
+                                       [](const auto& a, const auto& b) { return a.second < b.second; });
+        if (estimate <= victim->second) {
+            minValue_ = victim->second;
+            return;
+        }
+        entries_.erase(victim);
+        entries_.emplace(word, estimate);
+        
+        minValue_ = estimate;
+        for (const auto& entry : entries_) {
+            minValue_ = std::min(minValue_, entry.second);
+        }
+    }
+    
+    const std::unordered_map<std::string, std::uint64_t>& entries() const { return entries_; }
+    
+private:
+    size_t capacity_;
+    std::uint64_t minValue_;
+    std::unordered_map<std::string, std::uint64_t> entries_;
+};
+
+// Скетчи потоков, накапливаемые по блокам текста
+struct SketchState {
+    SketchState(const WordSketchOptions& options, int threads)
+        : threads(threads),
+          sketches(threads, CountMinSketch(options.width, options.depth)),
+          cardinality(threads, HyperLogLog(options.hllPrecision)),
+          candidates(threads, TopCandidates(options.candidates)),
+          words(threads, 0) {}
+    
+    // Блок должен заканчиваться на границе слова
+    void add(const unsigned char* bytes, size_t length) {
+        std::vector<size_t> bounds = wordChunkBounds(bytes, length, threads);
+        
+        #pragma omp parallel for num_threads(threads) schedule(static, 1)
+        for (int t = 0; t < threads; ++t) {
+            forEachWord(bytes, bounds[t], bounds[t + 1], length, [&](const std::string& word) {
+                std::uint64_t hash = WordSketchAnalyzer::hashWord(word);
+                sketches[t].add(hash);
+                cardinality[t].add(hash);
+                candidates[t].offer(word, sketches[t].estimate(hash));
+                words[t]++;
+            });
+        }
+    }
+    
+    WordSketchResult finish(const WordSketchOptions& options);
+    
+    int threads;
+    std::vector<CountMinSketch> sketches;
+    std::vector<HyperLogLog> cardinality;
+    std::vector<TopCandidates> candidates;
+    std::vector<std::uint64_t> words;
+};
+
+// Слияние: сумма скетчей, максимум регистров, объединение кандидатов
+WordSketchResult SketchState::finish(const WordSketchOptions& options) {
+    WordSketchResult result;
+    result.threadsUsed = threads;
+    for (int t = 0; t < threads; ++t) {
+        result.memoryBytes += sketches[t].memoryBytes() + cardinality[t].memoryBytes();
+        result.totalWords += words[t];
+        if (t > 0) {
+            sketches[0].merge(sketches[t]);
+            cardinality[0].merge(cardinality[t]);
+        }
+    }
+    result.distinctEstimate = cardinality[0].estimate();
+    
+    std::unordered_set<std::string> seen;
+    for (const auto& list : candidates) {
+        for (const auto& entry : list.entries()) {
+            if (seen.insert(entry.first).second) {
+                result.topWords.emplace_back(
+                    entry.first, sketches[0].estimate(WordSketchAnalyzer::hashWord(entry.first)));
+            }
+        }
+    }
+    std::sort(result.topWords.begin(), result.topWords.end(),
+              [](const auto& a, const auto& b) {
+                  return a.second != b.second ? a.second > b.second : a.first < b.first;
+              });
+    if (result.topWords.size() > options.topK) {
+        result.topWords.resize(options.topK);
+    }
+    return result;
+}
+
+} // namespace
+
+WordSketchResult WordSketchAnalyzer::analyze(const std::string& text,
+                                             const WordSketchOptions& options) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    int threads = options.threads > 0 ? options.threads : omp_get_max_threads();
+    
+    SketchState state(options, threads);
+    state.add(reinterpret_cast<const unsigned char*>(text.data()), text.length());
+    WordSketchResult result = state.finish(options);
+    
+    result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime
+    );
+    return result;
+}
+
+WordSketchResult WordSketchAnalyzer::analyzeFile(const std::string& filename,
+                                                 const WordSketchOptions& options) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    int threads = options.threads > 0 ? options.threads : omp_get_max_threads();
+    
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    
+    SketchState state(options, threads);
+    size_t blockBytes = std::max<size_t>(options.blockBytes, 1);
+    std::vector<char> buffer(2 * blockBytes);
+    size_t carry = 0;
+    
+    while (true) {
+        // Хвост прошлого блока (незаконченное слово) уже лежит в начале буфера
+        if (buffer.size() < carry + blockBytes) {
+            buffer.resize(carry + blockBytes);
+        }
+        file.read(buffer.data() + carry, static_cast<std::streamsize>(blockBytes));
+        size_t length = carry + static_cast<size_t>(file.gcount());
+        bool last = !file;
+        
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(buffer.data());
+        size_t cut = length;
+        if (!last) {
+            while (cut > 0 && (bytes[cut - 1] >= 0x80 || std::isalnum(bytes[cut - 1]))) {
+                cut--;
+            }
+            // Блок без разделителей режется как есть, чтобы буфер не рос
+            if (cut == 0) {
+                cut = length;
+            }
+        }
+        
+        state.add(bytes, cut);
+        carry = length - cut;
+        std::memmove(buffer.data(), buffer.data() + cut, carry);
+        
+        if (last) {
+            break;
+        }
+    }
+    
+    WordSketchResult result = state.finish(options);
+    result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime
+    );
+    return result;
+}
+
+WordCountResult WordSketchAnalyzer::exactCounts(const std::string& text, int threads) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    if (threads <= 0) {
+        threads = omp_get_max_threads();
+    }
+    
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    size_t length = text.length();
+    std::vector<size_t> bounds = wordChunkBounds(bytes, length, threads);
+    std::vector<std::unordered_map<std::string, std::uint64_t>> local(threads);
+    
+    #pragma omp parallel for num_threads(threads) schedule(static, 1)
+    for (int t = 0; t < threads; ++t) {
+        forEachWord(bytes, bounds[t], bounds[t + 1], length,
+                    [&](const std::string& word) { local[t][word]++; });
+    }
+    
+    for (int t = 1; t < threads; ++t) {
+        for (const auto& entry : local[t]) {
+            local[0][entry.first] += entry.second;
+        }
+    }
+    
+    WordCountResult result;
+    result.counts.assign(local[0].begin(), local[0].end());
+    for (const auto& entry : result.counts) {
+        result.totalWords += entry.second;
+    }
+    std::sort(result.counts.begin(), result.counts.end(),
+              [](const auto& a, const auto& b) {
+                  return a.second != b.second ? a.second > b.second : a.first < b.first;
+              });
+    
+    result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime
+    );
+    return result;
+}
+
+void WordSketchAnalyzer::printResults(const WordSketchResult& sketch) {
+    std::cout << "WORD SKETCH" << std::endl;
+    std::cout << "\nSketch time: " << sketch.processingTime.count() / 1000.0 << " ms" << std::endl;
+    std::cout << "Sketch memory: " << sketch.memoryBytes / 1024 << " KiB ("
+              << sketch.threadsUsed << " threads)" << std::endl;
+    std::cout << "Words: " << sketch.totalWords << std::endl;
+    std::cout << "Distinct words (estimate): " << std::fixed << std::setprecision(0)
+              << sketch.distinctEstimate << std::endl;
+    
+    std::cout << "\nTop " << sketch.topWords.size() << " words (estimate):" << std::endl;
+    for (size_t i = 0; i < sketch.topWords.size(); ++i) {
+        std::cout << "   " << std::setw(2) << (i + 1) << ". " << sketch.topWords[i].first
+                  << " : " << sketch.topWords[i].second << std::endl;
+    }
+}
+
+void WordSketchAnalyzer::printComparison(const WordSketchResult& sketch,
+                                         const WordCountResult& exact) {
+    std::cout << "WORD SKETCH VS EXACT COUNTS" << std::endl;
+    
+    std::unordered_map<std::string, std::uint64_t> exactIndex;
+    for (const auto& entry : exact.counts) {
+        exactIndex.emplace(entry.first, entry.second);
+    }
+    
+    double distinct = static_cast<double>(exact.counts.size());
+    std::cout << "\nSketch time: " << sketch.processingTime.count() / 1000.0 << " ms, "
+              << "exact time: " << exact.processingTime.count() / 1000.0 << " ms" << std::endl;
+    std::cout << "Sketch memory: " << sketch.memoryBytes / 1024 << " KiB ("
+              << sketch.threadsUsed << " threads)" << std::endl;
+    std::cout << "Words: " << sketch.totalWords << " (exact " << exact.totalWords << ")" << std::endl;
+    std::cout << "Distinct words: " << std::fixed << std::setprecision(0) << sketch.distinctEstimate
+              << " (exact " << exact.counts.size() << ", error "
+              << std::setprecision(2) << (sketch.distinctEstimate - distinct) * 100.0 / distinct
+              << "%)" << std::endl;
+    
+    // Полнота списка частых слов и ошибка оценок
+    size_t k = sketch.topWords.size();
+    std::uint64_t threshold = k > 0 && !exact.counts.empty() ?
+        exact.counts[std::min(k, exact.counts.size()) - 1].second : 0;
+    size_t hits = 0;
+    double errorSum = 0.0;
+    std::cout << "\nTop " << k << " words (estimate / exact):" << std::endl;
+    for (size_t i = 0; i < k; ++i) {
+        const auto& word = sketch.topWords[i];
+        std::uint64_t truth = exactIndex.count(word.first) ? exactIndex[word.first] : 0;
+        if (truth > 0 && truth >= threshold) {
+            hits++;
+        }
+        errorSum += truth > 0 ? (static_cast<double>(word.second) - truth) / truth : 1.0;
+        
+        std::cout << "   " << std::setw(2) << (i + 1) << ". " << word.first << " : "
+                  << word.second << " / " << truth << std::endl;
+    }
+    
+    if (k > 0) {
+        std::cout << "\nTop-" << k << " recall: " << std::setprecision(1)
+                  << hits * 100.0 / k << "%" << std::endl;
+        std::cout << "Mean relative overestimate: " << std::setprecision(4)
+                  << errorSum * 100.0 / k << "%" << std::endl;
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef WORD_SKETCH_HPP
+#define WORD_SKETCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Count-Min Sketch: depth строк по width счетчиков, оценка - минимум по
+// строкам (никогда не меньше точного значения). Сливается сложением
+class CountMinSketch {
+public:
+    explicit CountMinSketch(size_t width = 1 << 16, int depth = 4);
+    
+    void add(std::uint64_t hash, std::uint64_t count = 1);
+    std::uint64_t estimate(std::uint64_t hash) const;
+    void merge(const CountMinSketch& other);
+    
+    size_t memoryBytes() const { return table_.size() * sizeof(std::uint64_t); }
+    
+private:
+    size_t width_;
+    size_t mask_;
+    int depth_;
+    std::vector<std::uint64_t> table_;
+};
+
+// HyperLogLog: 2^precision регистров по байту, сливается максимумом
+class HyperLogLog {
+public:
+    explicit HyperLogLog(int precision = 14);
+    
+    void add(std::uint64_t hash);
+    double estimate() const;
+    void merge(const HyperLogLog& other);
+    
+    size_t memoryBytes() const { return registers_.size(); }
+    
+private:
+    int precision_;
+    std::vector<std::uint8_t> registers_;
+};
+
+struct WordSketchOptions {
+    size_t width = 1 << 16;     // Счетчиков в строке Count-Min (степень двойки)
+    int depth = 4;
+    int hllPrecision = 14;
+    size_t topK = 20;
+    size_t candidates = 512;    // Кандидатов в частые слова на поток
+    int threads = 0;
+    size_t blockBytes = 4 << 20;    // Блок чтения в analyzeFile
+};
+
+struct WordSketchResult {
+    std::uint64_t totalWords = 0;
+    double distinctEstimate = 0.0;
+    std::vector<std::pair<std::string, std::uint64_t>> topWords;  // По оценке
+    size_t memoryBytes = 0;     // Память скетчей всех потоков
+    std::chrono::microseconds processingTime{0};
+    int threadsUsed = 0;
+};
+
+// Точный подсчет для сравнения
+struct WordCountResult {
+    std::uint64_t totalWords = 0;
+    std::vector<std::pair<std::string, std::uint64_t>> counts;  // По убыванию
+    std::chrono::microseconds processingTime{0};
+};
+
+// Подсчет слов в ограниченной памяти. Слова - как в analyzeStatistics
+// (русские и латинские буквы, цифры), приводятся к нижнему регистру.
+// Каждый поток ведет свой скетч и список кандидатов в частые слова;
+// после слияния кандидаты переоцениваются по общему скетчу
+class WordSketchAnalyzer {
+public:
+    static WordSketchResult analyze(const std::string& text,
+                                    const WordSketchOptions& options = WordSketchOptions());
+    
+    // Файл читается блоками по options.blockBytes, слово на границе блока
+    // переносится в следующий: память не зависит от размера файла
+    static WordSketchResult analyzeFile(const std::string& filename,
+                                        const WordSketchOptions& options = WordSketchOptions());
+    
+    static WordCountResult exactCounts(const std::string& text, int threads = 0);
+    
+    static void printResults(const WordSketchResult& sketch);
+    
+    // Сравнение с точным подсчетом: частые слова, ошибки, память
+    static void printComparison(const WordSketchResult& sketch, const WordCountResult& exact);
+    
+    static std::uint64_t hashWord(const std::string& word);
+};
+
+#endif // WORD_SKETCH_HPP
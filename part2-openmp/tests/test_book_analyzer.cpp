@@ -1,4 +1,23 @@
 #include "book_analyzer.hpp"
+#include "frequency_index.hpp"
+#include "sliding_window.hpp"
+#include "text_encoding.hpp"
+#include "sampling_analyzer.hpp"
+#include "word_sketch.hpp"
+#include "phrase_matcher.hpp"
+#include "auto_tuner.hpp"
+#include "async_reader.hpp"
+#include "analysis_server.hpp"
+#include "directory_watcher.hpp"
+#include "profile_matcher.hpp"
+#include "bookanalyzer.h"
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <omp.h>
 #include <gtest/gtest.h>
 
 TEST(BookAnalyzerTest, ASCIILetterDetection) {
@@ -57,7 +76,7 @@ TEST(BookAnalyzerTest, DifferentThreadCounts) {
     // Тестируем с разным количеством потоков
     std::vector<int> threadCounts = {1, 2};
     
-    std::map<std::string, int> firstResult;
+    std::map<std::string, std::uint64_t> firstResult;
     
     for (int threads : threadCounts) {
         auto result = analyzer.analyzeText(repeatedText, threads);
@@ -114,6 +133,840 @@ TEST(BookAnalyzerTest, TestTextFunction) {
     EXPECT_GT(testText.length(), 0);
 }
 
+TEST(BookAnalyzerTest, CapitalYoIsCounted) {
+    BookAnalyzer analyzer;
+    
+    // Заглавная и строчная ё считаются одной буквой
+    auto result = analyzer.analyzeText("Ёлка ёж", 1);
+    std::string yo = BookAnalyzer::letterFromIndex(6);
+    
+    EXPECT_EQ(result.totalLetters, 6);
+    EXPECT_EQ(result.letterFrequency[yo], 2);
+}
+
+TEST(BookAnalyzerTest, LetterIndexCoversAlphabet) {
+    std::string lower = "абвгдеёжзийклмнопрстуфхцчшщъыьэюя";
+    std::string upper = "АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+    const unsigned char* l = reinterpret_cast<const unsigned char*>(lower.data());
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(upper.data());
+    
+    for (int i = 0; i < BookAnalyzer::ALPHABET_SIZE; ++i) {
+        EXPECT_EQ(BookAnalyzer::letterIndexUTF8(l, 2 * i, lower.size()), i);
+        EXPECT_EQ(BookAnalyzer::letterIndexUTF8(u, 2 * i, upper.size()), i);
+        EXPECT_EQ(BookAnalyzer::letterFromIndex(i), lower.substr(2 * i, 2));
+    }
+}
+
+TEST(BookAnalyzerTest, FrequencyIndexMatchesAnalyzeText) {
+    BookAnalyzer analyzer;
+    
+    std::string text;
+    for (int i = 0; i < 300; ++i) {
+        text += "Алексей Фёдорович Карамазов, 1879 год. ЁЖИК ";
+    }
+    
+    // Маленький шаг: границы блоков и диапазонов режут буквы пополам
+    auto index = FrequencyIndex::build(text, 37, 2);
+    EXPECT_EQ(index.checkpointCount(), (text.size() + 36) / 37 + 1);
+    
+    std::vector<std::pair<size_t, size_t>> ranges = {
+        {0, text.size()}, {0, 0}, {5, 6}, {1, 200}, {37, 74}, {101, 4001}, {999, text.size()}
+    };
+    for (const auto& range : ranges) {
+        std::string part = text.substr(range.first, range.second - range.first);
+        auto expected = analyzer.analyzeText(part, 1);
+        auto actual = index.query(text, range.first, range.second);
+        
+        EXPECT_EQ(actual.totalLetters, expected.totalLetters);
+        EXPECT_EQ(actual.letterFrequency, expected.letterFrequency);
+    }
+    
+    EXPECT_THROW(index.query(text, 10, text.size() + 1), std::out_of_range);
+    EXPECT_THROW(index.query(text + "а", 0, 1), std::runtime_error);
+}
+
+TEST(BookAnalyzerTest, FrequencyIndexSaveLoad) {
+    std::string text;
+    for (int i = 0; i < 100; ++i) {
+        text += "Быстрая коричневая лиса прыгает через ленивую собаку. ";
+    }
+    auto index = FrequencyIndex::build(text, 128, 2);
+    
+    std::string filename = "test_frequency_index.bin";
+    index.save(filename);
+    auto loaded = FrequencyIndex::load(filename);
+    
+    EXPECT_EQ(loaded.stride(), 128u);
+    EXPECT_EQ(loaded.textLength(), text.size());
+    EXPECT_EQ(loaded.histogram(text, 17, text.size() - 3),
+              index.histogram(text, 17, text.size() - 3));
+    
+    std::remove(filename.c_str());
+    EXPECT_THROW(FrequencyIndex::load(filename), std::runtime_error);
+}
+
+TEST(BookAnalyzerTest, SlidingWindowMatchesDirectCount) {
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += "Мальчики, милые мальчики, " + std::to_string(i) + " ЁЛКИ. ";
+    }
+    
+    std::vector<std::uint8_t> letters;
+    std::vector<size_t> offsets;
+    SlidingWindowAnalyzer::extractLetters(text, 2, letters, offsets);
+    
+    // Перекрывающиеся и непересекающиеся окна, разное число сегментов
+    for (size_t step : {1u, 7u, 50u, 120u}) {
+        for (int threads : {1, 3}) {
+            auto series = SlidingWindowAnalyzer::compute(text, 100, step, threads);
+            ASSERT_EQ(series.windows(), (letters.size() - 100) / step + 1);
+            
+            for (size_t w = 0; w < series.windows(); w += 13) {
+                BookAnalyzer::LetterHistogram expected{};
+                for (size_t k = w * step; k < w * step + 100; ++k) {
+                    expected[letters[k]]++;
+                }
+                const std::uint64_t* actual = series.histogram(w);
+                EXPECT_TRUE(std::equal(expected.begin(), expected.end(), actual));
+                EXPECT_EQ(series.startByte[w], offsets[w * step]);
+            }
+        }
+    }
+    
+    auto empty = SlidingWindowAnalyzer::compute(text, letters.size() + 1, 1, 2);
+    EXPECT_EQ(empty.windows(), 0u);
+    EXPECT_THROW(SlidingWindowAnalyzer::compute(text, 0, 1, 1), std::invalid_argument);
+}
+
+TEST(BookAnalyzerTest, FusedStatisticsCountsWordsAndSentences) {
+    BookAnalyzer analyzer;
+    
+    std::string text = "Ёлка стоит. Мальчики, 12 детей!.. Кто там?! Конец";
+    auto stats = analyzer.analyzeStatistics(text, 1);
+    
+    // Слова: Ёлка стоит Мальчики 12 детей Кто там Конец
+    EXPECT_EQ(stats.words, 8u);
+    EXPECT_EQ(stats.sentences, 4u);
+    EXPECT_EQ(stats.wordLengths[2], 1u);
+    EXPECT_EQ(stats.wordLengths[3], 2u);
+    EXPECT_EQ(stats.wordLengths[4], 1u);
+    EXPECT_EQ(stats.wordLengths[5], 3u);
+    EXPECT_EQ(stats.wordLengths[8], 1u);
+    EXPECT_EQ(stats.totalLetters, static_cast<std::uint64_t>(analyzer.analyzeText(text, 1).totalLetters));
+}
+
+TEST(BookAnalyzerTest, FusedStatisticsIndependentOfPartitioning) {
+    BookAnalyzer analyzer;
+    
+    std::string text;
+    for (int i = 0; i < 50; ++i) {
+        text += "Алексей Фёдорович... Карамазов был третьим сыном! Dmitri " + std::to_string(i) + "? ";
+    }
+    text += "конец";
+    
+    auto expected = analyzer.analyzeStatistics(text, 1);
+    EXPECT_EQ(expected.words, 50u * 8 + 1);
+    EXPECT_EQ(expected.sentences, 50u * 3 + 1);
+    
+    // Много потоков на коротком тексте: границы участков режут слова
+    for (int threads : {2, 3, 7, 64}) {
+        auto actual = analyzer.analyzeStatistics(text, threads);
+        EXPECT_EQ(actual.letters, expected.letters);
+        EXPECT_EQ(actual.words, expected.words);
+        EXPECT_EQ(actual.sentences, expected.sentences);
+        EXPECT_EQ(actual.wordLengths, expected.wordLengths);
+    }
+}
+
+// Перекодирование строчного русского текста из UTF-8 в однобайтовую
+// кодировку по ее таблице (строчные буквы и ё)
+static std::string encodeLowercase(const std::string& utf8, TextEncoding encoding) {
+    const auto& table = TextDecoder::letterTable(encoding);
+    int lowerFirst = encoding == TextEncoding::CP1251 ? 0xE0 : 0xC0;
+    unsigned char yo = encoding == TextEncoding::CP1251 ? 0xB8 : 0xA3;
+    
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(utf8.data());
+    std::string encoded;
+    for (size_t i = 0; i < utf8.size(); ++i) {
+        int index = BookAnalyzer::letterIndexUTF8(bytes, i, utf8.size());
+        if (index < 0) {
+            encoded += utf8[i];
+            continue;
+        }
+        unsigned char byte = yo;
+        for (int b = lowerFirst; b < lowerFirst + 32; ++b) {
+            if (table[b] == index) byte = static_cast<unsigned char>(b);
+        }
+        encoded += static_cast<char>(byte);
+        i++;
+    }
+    return encoded;
+}
+
+TEST(BookAnalyzerTest, SingleByteEncodingsMatchUTF8) {
+    std::string utf8;
+    for (int i = 0; i < 100; ++i) {
+        utf8 += "съешь же ещё этих мягких французских булок, да выпей чаю. ";
+    }
+    auto expected = TextDecoder::countLetters(utf8, TextEncoding::UTF8, 1);
+    EXPECT_EQ(TextDecoder::detect(utf8), TextEncoding::UTF8);
+    
+    for (TextEncoding encoding : {TextEncoding::CP1251, TextEncoding::KOI8R}) {
+        std::string encoded = encodeLowercase(utf8, encoding);
+        EXPECT_EQ(TextDecoder::detect(encoded), encoding) << TextDecoder::name(encoding);
+        EXPECT_EQ(TextDecoder::countLetters(encoded, encoding, 2), expected);
+        
+        auto result = TextDecoder::analyze(encoded, encoding, 2);
+        EXPECT_EQ(result.letterFrequency, BookAnalyzer().analyzeText(utf8, 1).letterFrequency);
+    }
+    
+    // Заглавные буквы: ПРИВЕТ в обеих кодировках
+    std::string cp1251 = "\xCF\xD0\xC8\xC2\xC5\xD2";
+    std::string koi8 = "\xF0\xF2\xE9\xF7\xE5\xF4";
+    auto upper = TextDecoder::countLetters(std::string("привет"), TextEncoding::UTF8, 1);
+    EXPECT_EQ(TextDecoder::countLetters(cp1251, TextEncoding::CP1251, 1), upper);
+    EXPECT_EQ(TextDecoder::countLetters(koi8, TextEncoding::KOI8R, 1), upper);
+    
+    EXPECT_EQ(TextDecoder::parse("Windows-1251"), TextEncoding::CP1251);
+    EXPECT_THROW(TextDecoder::parse("latin1"), std::invalid_argument);
+}
+
+TEST(BookAnalyzerTest, SamplingEstimatesFrequencies) {
+    std::string text;
+    for (int i = 0; i < 4000; ++i) {
+        text += "Быстрая коричневая лиса прыгает через ленивую собаку " + std::to_string(i) + ". ";
+    }
+    std::string filename = "test_sampling_input.txt";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << text;
+    }
+    
+    BookAnalyzer analyzer;
+    auto exact = TextDecoder::countLetters(text, TextEncoding::UTF8, 1);
+    std::uint64_t exactTotal = 0;
+    for (auto count : exact) exactTotal += count;
+    
+    // Нечетный размер блока: границы режут буквы; полный проход - точный
+    SamplingOptions full;
+    full.blockSize = 1001;
+    full.targetError = 0.0;
+    full.threads = 2;
+    auto all = SamplingAnalyzer::analyzeFile(filename, full);
+    EXPECT_EQ(all.sampled, exact);
+    EXPECT_EQ(all.bytesRead, text.size());
+    EXPECT_TRUE(all.converged);
+    EXPECT_DOUBLE_EQ(all.maxHalfWidth(), 0.0);
+    
+    // Ранняя остановка: прочитана часть файла, доли в пределах интервалов
+    // (с запасом: 95% интервал по одной букве из 33 может промахнуться)
+    SamplingOptions quick;
+    quick.blockSize = 512;
+    quick.targetError = 0.01;
+    quick.threads = 2;
+    auto sample = SamplingAnalyzer::analyzeFile(filename, quick);
+    EXPECT_TRUE(sample.converged);
+    EXPECT_LT(sample.bytesRead, sample.totalBytes);
+    EXPECT_LE(sample.maxHalfWidth(), 0.01);
+    for (int a = 0; a < BookAnalyzer::ALPHABET_SIZE; ++a) {
+        double truth = static_cast<double>(exact[a]) / exactTotal;
+        EXPECT_NEAR(sample.share[a], truth, 3 * sample.halfWidth[a] + 1e-9);
+    }
+    
+    std::remove(filename.c_str());
+}
+
+TEST(BookAnalyzerTest, WordSketchMatchesExactCounts) {
+    // Частоты слов: Алёша 400, брат 200, Митя 100, остальные по разу
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        text += "w" + std::to_string(i) + " ";
+        if (i % 30 == 0) text += "Митя, ";
+        if (i % 15 == 0) text += "БРАТ. ";
+        if (i % 15 == 7) text += "брат ";
+        if (i % 15 < 2) text += "Алёша! ";
+    }
+    
+    auto exact = WordSketchAnalyzer::exactCounts(text, 1);
+    ASSERT_GE(exact.counts.size(), 3u);
+    EXPECT_EQ(exact.counts[0], std::make_pair(std::string("алёша"), std::uint64_t(400)));
+    EXPECT_EQ(exact.counts[1], std::make_pair(std::string("брат"), std::uint64_t(400)));
+    
+    WordSketchOptions options;
+    options.topK = 3;
+    options.width = 1 << 12;
+    options.candidates = 64;
+    for (int threads : {1, 3}) {
+        options.threads = threads;
+        auto sketch = WordSketchAnalyzer::analyze(text, options);
+        
+        EXPECT_EQ(sketch.totalWords, exact.totalWords);
+        ASSERT_EQ(sketch.topWords.size(), 3u);
+        EXPECT_EQ(sketch.topWords[2].first, "митя");
+        for (const auto& word : sketch.topWords) {
+            // Count-Min не занижает
+            auto it = std::find_if(exact.counts.begin(), exact.counts.end(),
+                                   [&](const auto& e) { return e.first == word.first; });
+            ASSERT_NE(it, exact.counts.end());
+            EXPECT_GE(word.second, it->second);
+        }
+        
+        double distinct = static_cast<double>(exact.counts.size());
+        EXPECT_NEAR(sketch.distinctEstimate, distinct, distinct * 0.05);
+    }
+    
+    // Память не зависит от объема текста
+    auto small = WordSketchAnalyzer::analyze("один два", options);
+    EXPECT_EQ(small.memoryBytes, WordSketchAnalyzer::analyze(text, options).memoryBytes);
+    
+    // Чтение блоками: границы режут слова и буквы, но слова переносятся
+    // целиком, и в одном потоке результат совпадает с анализом всего текста
+    std::ofstream("test_sketch.txt", std::ios::binary) << text;
+    options.threads = 1;
+    options.blockBytes = 37;
+    auto whole = WordSketchAnalyzer::analyze(text, options);
+    auto streamed = WordSketchAnalyzer::analyzeFile("test_sketch.txt", options);
+    EXPECT_EQ(streamed.totalWords, whole.totalWords);
+    EXPECT_EQ(streamed.topWords, whole.topWords);
+    EXPECT_EQ(streamed.distinctEstimate, whole.distinctEstimate);
+    std::remove("test_sketch.txt");
+}
+
+TEST(BookAnalyzerTest, PhraseMatcherMatchesNaiveSearch) {
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += "Алёша Карамазов и Иван Карамазов; братья Карамазовы, аааа. ";
+    }
+    
+    // Перекрывающиеся фразы и фразы-суффиксы других фраз
+    std::vector<std::string> patterns = {
+        "Карамазов", "Карамазовы", "азов", "Алёша", "аа", "Иван Карамазов", "Смердяков"
+    };
+    
+    std::vector<std::uint64_t> expected;
+    for (const auto& pattern : patterns) {
+        std::uint64_t count = 0;
+        for (size_t pos = text.find(pattern); pos != std::string::npos;
+             pos = text.find(pattern, pos + 1)) {
+            count++;
+        }
+        expected.push_back(count);
+    }
+    
+    PhraseMatcher matcher(patterns);
+    // Много потоков: границы участков попадают внутрь фраз
+    for (int threads : {1, 2, 5, 33}) {
+        EXPECT_EQ(matcher.count(text, threads), expected);
+    }
+    EXPECT_EQ(expected[0], 600u);
+    EXPECT_EQ(expected[4], 600u);
+    
+    auto result = matcher.countResult(text, 2);
+    EXPECT_EQ(result.letterFrequency["Алёша"], 200);
+    EXPECT_EQ(result.sortedLetters.front().second, 600);
+    
+    EXPECT_THROW(PhraseMatcher({"ok", ""}), std::invalid_argument);
+}
+
+TEST(BookAnalyzerTest, ScheduleDoesNotChangeResult) {
+    BookAnalyzer analyzer;
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text += "Быстрая коричневая лиса прыгает через ленивую собаку. ";
+    }
+    
+    auto expected = analyzer.analyzeText(text, 1);
+    for (auto schedule : {BookAnalyzer::ScheduleKind::Static,
+                          BookAnalyzer::ScheduleKind::Dynamic,
+                          BookAnalyzer::ScheduleKind::Guided}) {
+        for (int chunk : {1, 7, 65536}) {
+            auto result = analyzer.analyzeTextWith(text, {2, schedule, chunk});
+            EXPECT_EQ(result.letterFrequency, expected.letterFrequency);
+            EXPECT_EQ(result.threadsUsed, 2);
+        }
+    }
+}
+
+TEST(BookAnalyzerTest, AutoTunerCachesAndPersistsDecision) {
+    EXPECT_EQ(AutoTuner::sizeClass(1), 0);
+    EXPECT_EQ(AutoTuner::sizeClass(1024), 10);
+    EXPECT_EQ(AutoTuner::sizeClass(2047), 10);
+    
+    std::string text;
+    for (int i = 0; i < 300; ++i) {
+        text += "Алексей Фёдорович Карамазов был третьим сыном. ";
+    }
+    std::string profile = "test_tuning_profile.txt";
+    std::remove(profile.c_str());
+    
+    AutoTuner tuner(profile);
+    tuner.repetitions = 1;
+    std::string source;
+    auto config = tuner.choose(text, &source);
+    EXPECT_EQ(source, "benchmark");
+    EXPECT_GE(config.threads, 1);
+    
+    // Тот же класс размера - из кеша
+    auto again = tuner.choose(text.substr(0, text.size() - 10), &source);
+    EXPECT_EQ(source, "cache");
+    EXPECT_EQ(again.chunk, config.chunk);
+    
+    tuner.save();
+    AutoTuner restored(profile);
+    auto loaded = restored.choose(text, &source);
+    EXPECT_EQ(source, "profile");
+    EXPECT_EQ(loaded.threads, config.threads);
+    EXPECT_EQ(loaded.schedule, config.schedule);
+    EXPECT_EQ(loaded.chunk, config.chunk);
+    
+    std::remove(profile.c_str());
+}
+
+TEST(BookAnalyzerTest, KernelSpecializationsAgree) {
+    BookAnalyzer analyzer;
+    std::string text;
+    for (int i = 0; i < 500; ++i) {
+        text += "Ёлка и ёж. ЕЛЬ, Щука! Яблоко - \xD0\xD0\xD0\x80 abc ";
+    }
+    BookAnalyzer::TuningConfig config{2, BookAnalyzer::ScheduleKind::Static, 13};
+    
+    // Узкие и широкие счетчики дают одно и то же
+    BookAnalyzer::CountingOptions narrow;
+    narrow.counters = BookAnalyzer::CounterWidth::Narrow;
+    BookAnalyzer::CountingOptions wide;
+    wide.counters = BookAnalyzer::CounterWidth::Wide;
+    auto folded = analyzer.analyzeTextWith(text, config, narrow);
+    EXPECT_EQ(folded.letterFrequency, analyzer.analyzeTextWith(text, config, wide).letterFrequency);
+    EXPECT_EQ(folded.letterFrequency, analyzer.analyzeText(text, 1).letterFrequency);
+    EXPECT_EQ(folded.letterFrequency["ё"], 1000);
+    EXPECT_EQ(folded.letterFrequency["е"], 500);
+    
+    // ё как е
+    BookAnalyzer::CountingOptions noYo;
+    noYo.alphabet = BookAnalyzer::Alphabet::RussianYoAsYe;
+    auto merged = analyzer.analyzeTextWith(text, config, noYo);
+    EXPECT_EQ(merged.letterFrequency.count("ё"), 0u);
+    EXPECT_EQ(merged.letterFrequency["е"], 1500);
+    EXPECT_EQ(merged.totalLetters, folded.totalLetters);
+    
+    // Заглавные отдельно: в сумме столько же букв
+    BookAnalyzer::CountingOptions cased;
+    cased.foldCase = false;
+    auto separate = analyzer.analyzeTextWith(text, config, cased);
+    EXPECT_EQ(separate.letterFrequency["Ё"], 500);
+    EXPECT_EQ(separate.letterFrequency["ё"], 500);
+    EXPECT_EQ(separate.letterFrequency["Щ"], 500);
+    EXPECT_EQ(separate.letterFrequency["Е"], 500);
+    EXPECT_EQ(separate.letterFrequency.count("е"), 0u);
+    EXPECT_EQ(separate.totalLetters, folded.totalLetters);
+}
+
+TEST(BookAnalyzerTest, LetterStreamJoinsSplitLetters) {
+    BookAnalyzer analyzer;
+    std::string text = BookAnalyzer::createTestText() + "Ёж \xD0\xD0\xB0 ё";
+    auto expected = analyzer.analyzeText(text, 1);
+    
+    // Части по 1, 2 и 3 байта режут каждую букву
+    for (size_t step = 1; step <= 3; ++step) {
+        BookAnalyzer::LetterStream stream(2);
+        for (size_t pos = 0; pos < text.size(); pos += step) {
+            stream.add(text.data() + pos, std::min(step, text.size() - pos));
+        }
+        auto result = stream.result();
+        EXPECT_EQ(result.letterFrequency, expected.letterFrequency);
+        EXPECT_EQ(result.totalLetters, expected.totalLetters);
+        EXPECT_EQ(result.totalCharacters, text.size());
+    }
+}
+
+TEST(BookAnalyzerTest, LetterStreamCountsBeyond4GB) {
+    // Синтетический вход больше 4 ГБ без выделения памяти под него:
+    // одна часть подается со сдвигом, так что буквы режутся на стыках.
+    // Букв "а" больше INT_MAX, символов больше UINT32_MAX
+    const size_t letters = size_t(1) << 19;
+    std::string part;
+    for (size_t i = 0; i <= letters; ++i) {
+        part += "а";
+    }
+    
+    const size_t rounds = 2100;
+    BookAnalyzer::LetterStream stream;
+    for (size_t r = 0; r < rounds; ++r) {
+        stream.add(part.data(), part.size() - 1);
+        stream.add(part.data() + 1, part.size() - 1);
+    }
+    
+    auto result = stream.result();
+    std::uint64_t expectedLetters = static_cast<std::uint64_t>(rounds) * (2 * letters + 1);
+    std::uint64_t expectedCharacters = static_cast<std::uint64_t>(rounds) * 2 * (part.size() - 1);
+    EXPECT_GT(expectedLetters, static_cast<std::uint64_t>(INT32_MAX));
+    EXPECT_GT(expectedCharacters, static_cast<std::uint64_t>(UINT32_MAX));
+    EXPECT_EQ(result.letterFrequency["а"], expectedLetters);
+    EXPECT_EQ(result.totalLetters, expectedLetters);
+    EXPECT_EQ(result.totalCharacters, expectedCharacters);
+}
+
+TEST(BookAnalyzerTest, AsyncCorpusReaderMatchesWholeFileCount) {
+    std::string utf8;
+    for (int i = 0; i < 300; ++i) {
+        utf8 += "Съешь же ещё этих мягких французских булок, да выпей чаю. ";
+    }
+    std::string cp1251 = encodeLowercase(utf8.substr(utf8.find(' ')), TextEncoding::CP1251);
+    
+    std::vector<std::string> files = {"test_corpus_utf8.txt", "test_corpus_empty.txt",
+                                      "test_corpus_cp1251.txt"};
+    std::ofstream(files[0], std::ios::binary) << utf8;
+    std::ofstream(files[1], std::ios::binary);
+    std::ofstream(files[2], std::ios::binary) << cp1251;
+    
+    std::vector<ReaderBackend> backends = {ReaderBackend::ThreadPool};
+    if (AsyncCorpusReader::ioUringAvailable()) {
+        backends.push_back(ReaderBackend::IoUring);
+    }
+    
+    for (ReaderBackend backend : backends) {
+        // Нечетный блок режет буквы UTF-8, буферов меньше, чем блоков
+        AsyncReaderOptions options;
+        options.backend = backend;
+        options.blockBytes = 999;
+        options.queueDepth = 3;
+        options.threads = 2;
+        AsyncCorpusReader reader(options);
+        EXPECT_EQ(reader.backend(), backend);
+        
+        auto counts = reader.count(files);
+        ASSERT_EQ(counts.size(), 3u);
+        EXPECT_EQ(counts[0].encoding, TextEncoding::UTF8);
+        EXPECT_EQ(counts[0].letters, TextDecoder::countLetters(utf8, TextEncoding::UTF8, 1));
+        EXPECT_EQ(counts[0].bytes, utf8.size());
+        EXPECT_EQ(counts[1].bytes, 0u);
+        EXPECT_EQ(counts[2].encoding, TextEncoding::CP1251);
+        EXPECT_EQ(counts[2].letters, TextDecoder::countLetters(cp1251, TextEncoding::CP1251, 1));
+    }
+    
+    AsyncCorpusReader reader;
+    EXPECT_THROW(reader.count({"test_corpus_missing.txt"}), std::runtime_error);
+    
+    // Отсутствующий файл после заполнения очереди: ошибка, а не зависание,
+    // пока задачи определения кодировки предыдущих файлов еще идут
+    std::string large;
+    while (large.size() < (1 << 20)) {
+        large += utf8;
+    }
+    std::ofstream("test_corpus_large.txt", std::ios::binary) << large;
+    std::vector<std::string> withMissing(8, "test_corpus_large.txt");
+    withMissing.push_back("test_corpus_missing.txt");
+    withMissing.push_back("test_corpus_large.txt");
+    
+    for (ReaderBackend backend : backends) {
+        AsyncReaderOptions options;
+        options.backend = backend;
+        options.blockBytes = 256 * 1024;
+        options.queueDepth = 4;
+        options.threads = 4;
+        AsyncCorpusReader limited(options);
+        for (int run = 0; run < 20; ++run) {
+            EXPECT_THROW(limited.count(withMissing), std::runtime_error);
+        }
+    }
+    std::remove("test_corpus_large.txt");
+    
+    for (const auto& file : files) {
+        std::remove(file.c_str());
+    }
+}
+
+TEST(BookAnalyzerTest, AnalysisServerAnswersConcurrentRequests) {
+    ServerOptions options;
+    options.socketPath = "test_analysis_server.sock";
+    options.threads = 2;
+    options.smallRequestBytes = 4096;   // Большой текст идет отдельным путем
+    AnalysisServer server(options);
+    std::thread serverThread([&server] { server.run(); });
+    
+    std::string small = "Съешь же ещё этих мягких французских булок. ";
+    std::string large;
+    for (int i = 0; i < 200; ++i) {
+        large += small;
+    }
+    std::ofstream("test_server_input.txt", std::ios::binary) << large;
+    
+    BookAnalyzer analyzer;
+    auto expectedSmall = analyzer.analyzeText(small, 1);
+    auto expectedLarge = analyzer.analyzeText(large, 1);
+    
+    // Несколько клиентов одновременно: запросы попадают в общие пакеты
+    std::vector<std::thread> clients;
+    std::vector<std::string> responses(8);
+    for (size_t c = 0; c < responses.size(); ++c) {
+        clients.emplace_back([&, c] {
+            if (c % 4 == 3) {
+                responses[c] = AnalysisServer::request(options.socketPath,
+                                                       "FILE test_server_input.txt");
+            } else {
+                responses[c] = AnalysisServer::request(
+                    options.socketPath, "TEXT " + std::to_string(small.size()), small);
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    
+    for (size_t c = 0; c < responses.size(); ++c) {
+        auto result = AnalysisServer::parseResponse(responses[c]);
+        const auto& expected = c % 4 == 3 ? expectedLarge : expectedSmall;
+        EXPECT_EQ(result.letterFrequency, expected.letterFrequency);
+        EXPECT_EQ(result.totalCharacters, expected.totalCharacters);
+    }
+    
+    std::string missing = AnalysisServer::request(options.socketPath, "FILE no_such_file.txt");
+    EXPECT_EQ(missing.compare(0, 4, "ERR "), 0);
+    EXPECT_THROW(AnalysisServer::parseResponse(missing), std::runtime_error);
+    
+    // Длина больше предела или на грани переполнения: ERR и закрытие
+    std::string tooLong = AnalysisServer::request(
+        options.socketPath, "TEXT " + std::to_string(options.maxTextBytes + 1), small);
+    EXPECT_EQ(tooLong.compare(0, 4, "ERR "), 0);
+    std::string wrapping = AnalysisServer::request(
+        options.socketPath, "TEXT 18446744073709551615", small);
+    EXPECT_EQ(wrapping.compare(0, 4, "ERR "), 0);
+    
+    std::string stats = AnalysisServer::request(options.socketPath, "STATS");
+    EXPECT_EQ(stats.compare(0, 12, "OK requests="), 0);
+    EXPECT_EQ(AnalysisServer::request(options.socketPath, "SHUTDOWN"), "OK");
+    serverThread.join();
+    
+    auto latency = server.latency();
+    EXPECT_EQ(latency.requests, 9u);
+    EXPECT_LE(latency.p50, latency.p99);
+    EXPECT_LE(latency.p99, latency.max);
+    std::remove("test_server_input.txt");
+}
+
+// Профиль каталога прямым пересчетом всех файлов
+static BookAnalyzer::TextStatistics scanDirectory(const std::string& root) {
+    BookAnalyzer analyzer;
+    BookAnalyzer::TextStatistics total;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file()) {
+            total.add(analyzer.analyzeStatistics(
+                BookAnalyzer::readFileToString(entry.path().string()), 1));
+        }
+    }
+    return total;
+}
+
+static void expectSameProfile(const BookAnalyzer::TextStatistics& actual,
+                              const BookAnalyzer::TextStatistics& expected) {
+    EXPECT_EQ(actual.letters, expected.letters);
+    EXPECT_EQ(actual.totalLetters, expected.totalLetters);
+    EXPECT_EQ(actual.words, expected.words);
+    EXPECT_EQ(actual.sentences, expected.sentences);
+    EXPECT_EQ(actual.totalCharacters, expected.totalCharacters);
+}
+
+TEST(BookAnalyzerTest, DirectoryWatcherUpdatesIncrementally) {
+    namespace fs = std::filesystem;
+    const std::string root = "test_watch_dir";
+    fs::remove_all(root);
+    fs::create_directories(root + "/sub");
+    std::ofstream(root + "/a.txt") << "Мама мыла раму. Рама блестит!";
+    std::ofstream(root + "/sub/b.txt") << "Ёж и ёлка. ";
+    std::ofstream(root + "/c.txt") << "Третий файл без изменений.";
+    
+    // Ссылка на каталог-предок не обходится
+    fs::create_directory_symlink("..", root + "/sub/loop");
+    
+    DirectoryWatcher watcher(root, "", 1);
+    EXPECT_EQ(watcher.fileCount(), 3u);
+    EXPECT_EQ(watcher.analyzedFiles(), 3u);
+    expectSameProfile(watcher.aggregate(), scanDirectory(root));
+    
+    // Изменение одного файла: пересчитывается только он
+    std::ofstream(root + "/a.txt") << "Совсем другой текст, подлиннее прежнего. Да!";
+    EXPECT_EQ(watcher.poll(2000), 1u);
+    EXPECT_EQ(watcher.analyzedFiles(), 4u);
+    expectSameProfile(watcher.aggregate(), scanDirectory(root));
+    
+    // Удаление, перенос в каталог и новый подкаталог
+    fs::remove(root + "/sub/b.txt");
+    std::ofstream("test_watch_outside.txt") << "Перенесенный файл. ";
+    fs::rename("test_watch_outside.txt", root + "/moved.txt");
+    EXPECT_EQ(watcher.poll(2000), 2u);
+    fs::create_directories(root + "/new");
+    std::ofstream(root + "/new/d.txt") << "Новый каталог и новый файл.";
+    while (watcher.poll(500) > 0) {
+    }
+    EXPECT_EQ(watcher.fileCount(), 4u);
+    expectSameProfile(watcher.aggregate(), scanDirectory(root));
+    
+    // Удаление каталога вычитает все его файлы
+    fs::remove_all(root + "/new");
+    while (watcher.poll(500) > 0) {
+    }
+    EXPECT_EQ(watcher.fileCount(), 3u);
+    expectSameProfile(watcher.aggregate(), scanDirectory(root));
+    EXPECT_EQ(watcher.overflows(), 0u);
+    
+    fs::remove_all(root);
+}
+
+TEST(BookAnalyzerTest, CApiCountsCallerBuffer) {
+    EXPECT_EQ(ba_api_version(), BA_API_VERSION);
+    ba_context* context = ba_context_create(2);
+    ASSERT_NE(context, nullptr);
+    
+    std::string text = BookAnalyzer::createTestText();
+    auto expected = TextDecoder::countLetters(text, TextEncoding::UTF8, 1);
+    std::string cp1251 = encodeLowercase("ёлка и ежик, щука и яблоко", TextEncoding::CP1251);
+    
+    // Лишний элемент буфера не затрагивается
+    std::vector<std::uint64_t> counts(BA_ALPHABET_SIZE + 1, 777);
+    std::uint64_t total = 0;
+    ba_encoding detected = BA_ENCODING_AUTO;
+    
+    // Повторные вызовы с одним контекстом
+    for (int call = 0; call < 3; ++call) {
+        ASSERT_EQ(ba_count_letters(context, text.data(), text.size(), BA_ENCODING_AUTO,
+                                   counts.data(), counts.size(), &total, &detected), BA_OK);
+        EXPECT_EQ(detected, BA_ENCODING_UTF8);
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), counts.begin()));
+        EXPECT_EQ(counts[BA_ALPHABET_SIZE], 777u);
+    }
+    EXPECT_EQ(total, BookAnalyzer().analyzeText(text, 1).totalLetters);
+    
+    ASSERT_EQ(ba_context_set_chunk(context, 64), BA_OK);
+    ASSERT_EQ(ba_count_letters(context, cp1251.data(), cp1251.size(), BA_ENCODING_AUTO,
+                               counts.data(), counts.size(), &total, &detected), BA_OK);
+    EXPECT_EQ(detected, BA_ENCODING_CP1251);
+    EXPECT_EQ(total, 20u);
+    EXPECT_EQ(counts[6], 1u);
+    
+    char letter[8];
+    EXPECT_EQ(ba_letter_utf8(6, letter, sizeof(letter)), 2u);
+    EXPECT_STREQ(letter, "ё");
+    EXPECT_EQ(ba_letter_utf8(BA_ALPHABET_SIZE, letter, sizeof(letter)), 0u);
+    
+    // Ошибки возвращаются кодом и текстом в контексте
+    EXPECT_EQ(ba_count_letters(context, text.data(), text.size(), BA_ENCODING_UTF8,
+                               counts.data(), BA_ALPHABET_SIZE - 1, nullptr, nullptr),
+              BA_ERROR_BUFFER_TOO_SMALL);
+    EXPECT_STRNE(ba_last_error(context), "");
+    EXPECT_EQ(ba_count_letters(context, nullptr, 10, BA_ENCODING_UTF8,
+                               counts.data(), counts.size(), nullptr, nullptr),
+              BA_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(ba_count_letters(context, nullptr, 0, BA_ENCODING_UTF8,
+                               counts.data(), counts.size(), &total, nullptr), BA_OK);
+    EXPECT_EQ(total, 0u);
+    EXPECT_STREQ(ba_last_error(context), "");
+    
+    ba_context_destroy(context);
+    
+    // Расписание schedule(runtime) вызывающей программы не меняется
+    omp_set_schedule(omp_sched_guided, 7);
+    BookAnalyzer::TuningConfig config;
+    config.schedule = BookAnalyzer::ScheduleKind::Static;
+    BookAnalyzer::countLetters(text.data(), text.size(), config);
+    omp_sched_t kind;
+    int chunk;
+    omp_get_schedule(&kind, &chunk);
+    EXPECT_EQ(kind, omp_sched_guided);
+    EXPECT_EQ(chunk, 7);
+}
+
+// Меры различия по определению, без сведения к скалярному произведению
+static double referenceDistance(const BookAnalyzer::LetterHistogram& document,
+                                const BookAnalyzer::LetterHistogram& profile,
+                                ProfileMetric metric, double smoothing) {
+    const int n = BookAnalyzer::ALPHABET_SIZE;
+    double documentTotal = 0.0;
+    double profileTotal = 0.0;
+    double dot = 0.0;
+    double documentNorm = 0.0;
+    double profileNorm = 0.0;
+    for (int a = 0; a < n; ++a) {
+        documentTotal += document[a];
+        profileTotal += profile[a];
+        dot += static_cast<double>(document[a]) * profile[a];
+        documentNorm += static_cast<double>(document[a]) * document[a];
+        profileNorm += static_cast<double>(profile[a]) * profile[a];
+    }
+    if (metric == ProfileMetric::Cosine) {
+        return 1.0 - dot / std::sqrt(documentNorm * profileNorm);
+    }
+    
+    double distance = 0.0;
+    for (int a = 0; a < n; ++a) {
+        double p = (document[a] + smoothing) / (documentTotal + n * smoothing);
+        double q = (profile[a] + smoothing) / (profileTotal + n * smoothing);
+        distance += metric == ProfileMetric::ChiSquare ? (p - q) * (p - q) / q
+                                                       : p * std::log(p / q);
+    }
+    return distance;
+}
+
+TEST(BookAnalyzerTest, ProfileMatcherScoresAgainstAllProfiles) {
+    // Число эталонов не кратно ширине строки матрицы
+    std::mt19937 random(7);
+    std::vector<ReferenceProfile> profiles(37);
+    for (size_t p = 0; p < profiles.size(); ++p) {
+        profiles[p].name = "profile" + std::to_string(p);
+        for (auto& count : profiles[p].letters) {
+            count = random() % 1000;
+        }
+    }
+    profiles[5].letters[10] = 0;
+    
+    // Документы - зашумленные эталоны, последний без букв
+    std::vector<BookAnalyzer::LetterHistogram> documents;
+    for (size_t d = 0; d < 50; ++d) {
+        BookAnalyzer::LetterHistogram document = profiles[(d * 3) % profiles.size()].letters;
+        for (auto& count : document) {
+            count = count * 10 + random() % 5;
+        }
+        documents.push_back(document);
+    }
+    documents.push_back(BookAnalyzer::LetterHistogram{});
+    
+    ProfileMatcher matcher(profiles);
+    ASSERT_EQ(matcher.profileCount(), profiles.size());
+    
+    for (ProfileMetric metric : {ProfileMetric::ChiSquare, ProfileMetric::KLDivergence,
+                                 ProfileMetric::Cosine}) {
+        SCOPED_TRACE(ProfileMatcher::metricName(metric));
+        auto scores = matcher.score(documents, metric, 4);
+        ASSERT_EQ(scores.size(), documents.size() * profiles.size());
+        EXPECT_EQ(scores, matcher.score(documents, metric, 1));
+        
+        for (size_t d = 0; d + 1 < documents.size(); ++d) {
+            for (size_t p = 0; p < profiles.size(); ++p) {
+                double expected = referenceDistance(documents[d], profiles[p].letters, metric, 0.5);
+                EXPECT_NEAR(scores[d * profiles.size() + p], expected, 1e-9);
+            }
+        }
+        
+        auto best = matcher.bestMatch(documents, metric, 4);
+        for (size_t d = 0; d + 1 < documents.size(); ++d) {
+            EXPECT_EQ(best[d], (d * 3) % profiles.size());
+        }
+        if (metric == ProfileMetric::Cosine) {
+            EXPECT_DOUBLE_EQ(scores.back(), 1.0);
+        }
+    }
+    
+    // Сохранение и загрузка эталонов
+    ProfileMatcher::saveProfiles(profiles, "test_profiles.txt");
+    auto loaded = ProfileMatcher::loadProfiles("test_profiles.txt");
+    ASSERT_EQ(loaded.size(), profiles.size());
+    EXPECT_EQ(loaded[5].name, "profile5");
+    EXPECT_EQ(loaded[5].letters, profiles[5].letters);
+    std::remove("test_profiles.txt");
+    
+    EXPECT_THROW(ProfileMatcher(std::vector<ReferenceProfile>{}), std::invalid_argument);
+    EXPECT_THROW(ProfileMatcher::parseMetric("euclid"), std::invalid_argument);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,74 @@
+#!/bin/bash
+
+echo "=== MPI City Capture Benchmark ==="
+echo ""
+
+# Списки конфигураций можно переопределить через окружение
+CITIES_LIST=${CITIES_LIST:-"4 8 12 16 20"}
+NP_LIST=${NP_LIST:-"5 9 13 17 21"}
+REPETITIONS=${REPETITIONS:-5}
+
+# Длинные симуляции (много шагов на небольшом числе процессов) для
+# сравнения обычных и постоянных запросов и общей памяти узла
+STEPS_LIST=${STEPS_LIST:-"100 500 1000"}
+STEPS_NP=${STEPS_NP:-5}
+
+# Метка запуска - текущий коммит, чтобы сравнивать результаты между коммитами
+LABEL=$(git rev-parse --short HEAD 2>/dev/null || echo "unlabeled")
+
+# Создаем директорию сборки
+mkdir -p build results
+cd build
+
+# Собираем проект
+echo "Building project..."
+cmake .. -DCMAKE_BUILD_TYPE=Release
+make -j$(nproc) city_capture_bench
+
+CSV_FILE=../results/city_capture_benchmark.csv
+JSON_FILE=../results/city_capture_benchmark.jsonl
+
+echo ""
+echo "Label: $LABEL"
+echo ""
+
+for CITIES in $CITIES_LIST; do
+    echo "Cities: $CITIES"
+    echo "------------------------"
+    
+    for NP in $NP_LIST; do
+        # Лишние процессы сразу завершаются: замер совпал бы с np = cities + 1
+        if [ "$NP" -gt $((CITIES + 1)) ]; then
+            continue
+        fi
+        
+        echo -n "Processes $NP: "
+        mpirun -np "$NP" ./city_capture_bench "$CITIES" --repetitions "$REPETITIONS" \
+            --label "$LABEL" --csv "$CSV_FILE" --json "$JSON_FILE" || echo "failed"
+    done
+    
+    echo ""
+done
+
+echo "High step counts ($STEPS_NP processes)"
+echo "------------------------"
+
+for CITIES in $STEPS_LIST; do
+    for MODE in blocking persistent shared; do
+        MODE_FLAG=""
+        if [ "$MODE" = "persistent" ]; then
+            MODE_FLAG="--persistent"
+        elif [ "$MODE" = "shared" ]; then
+            MODE_FLAG="--shared-memory"
+        fi
+        
+        echo -n "Steps $CITIES ($MODE): "
+        mpirun -np "$STEPS_NP" ./city_capture_bench "$CITIES" $MODE_FLAG \
+            --repetitions "$REPETITIONS" --label "$LABEL" \
+            --csv "$CSV_FILE" --json "$JSON_FILE" || echo "failed"
+    done
+done
+
+echo ""
+echo "Benchmark completed!"
+echo "Results appended to results/city_capture_benchmark.csv and .jsonl"
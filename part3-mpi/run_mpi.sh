@@ -28,5 +28,31 @@ echo ""
 echo "3. Running with 21 processes (20 cities + commander):"
 mpirun -np 21 ./city_capture_app 20
 
+echo ""
+echo "4. Cipher matrix written with MPI-IO (20 cities):"
+mpirun -np 21 ./city_capture_app 20 --output cipher_matrix.bin | grep -E "Cipher matrix|SUCCESS|FAILURE"
+
+echo ""
+echo "5. Checkpoint overhead (20 cities, checkpoint every 5 steps):"
+CHECKPOINT_DIR=$(mktemp -d)
+mpirun -np 21 ./city_capture_app 20 --checkpoint-dir "$CHECKPOINT_DIR" --checkpoint-interval 5 --halt-after 12 | grep -E "Simulation time|Checkpoints|stopped"
+
+echo ""
+echo "6. Restart from the last checkpoint:"
+mpirun -np 21 ./city_capture_app 20 --checkpoint-dir "$CHECKPOINT_DIR" --checkpoint-interval 5 --restart | grep -E "Resuming|Simulation time|Checkpoints|SUCCESS|FAILURE"
+rm -rf "$CHECKPOINT_DIR"
+
+echo ""
+echo "7. MPI vs local shared-memory transport (20 cities, median of 5 after warmup):"
+COMPARE_CSV=transport_comparison.csv
+rm -f "$COMPARE_CSV"
+mpirun -np 21 ./city_capture_bench 20 --transport mpi --csv "$COMPARE_CSV"
+./city_capture_bench 20 --transport local --csv "$COMPARE_CSV"
+echo "   Results written to build/$COMPARE_CSV"
+
+echo ""
+echo "8. 20 cities on 5 processes (several cities per process):"
+mpirun -np 5 ./city_capture_app 20 --log-level warning | grep -E "per process|Simulation time|SUCCESS|FAILURE"
+
 echo ""
 echo "=== All simulations complete ==="
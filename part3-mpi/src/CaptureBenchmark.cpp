@@ -0,0 +1,216 @@
+#include "CaptureBenchmark.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+CountingTransport::CountingTransport(std::shared_ptr<CaptureTransport> inner)
+    : inner_(std::move(inner)), messages_(0), bytes_(0) {}
+
+void CountingTransport::send(const int* data, int count, int dest, int tag) {
+    ++messages_;
+    bytes_ += static_cast<std::uint64_t>(count) * sizeof(int);
+    inner_->send(data, count, dest, tag);
+}
+
+void CountingTransport::recv(int* data, int count, int source, int tag) {
+    inner_->recv(data, count, source, tag);
+}
+
+namespace {
+
+// Считает каждый запуск постоянной отправки как одно сообщение
+class CountingSendRequest : public PersistentRequest {
+public:
+    CountingSendRequest(std::unique_ptr<PersistentRequest> inner, int count,
+                        std::uint64_t& messages, std::uint64_t& bytes)
+        : inner_(std::move(inner)), count_(count), messages_(messages), bytes_(bytes) {}
+    
+    void start() override {
+        ++messages_;
+        bytes_ += static_cast<std::uint64_t>(count_) * sizeof(int);
+        inner_->start();
+    }
+    
+    void wait() override {
+        inner_->wait();
+    }
+    
+private:
+    std::unique_ptr<PersistentRequest> inner_;
+    int count_;
+    std::uint64_t& messages_;
+    std::uint64_t& bytes_;
+};
+
+} // namespace
+
+std::unique_ptr<PersistentRequest> CountingTransport::sendInit(const int* data, int count,
+                                                               int dest, int tag) {
+    return std::make_unique<CountingSendRequest>(inner_->sendInit(data, count, dest, tag),
+                                                 count, messages_, bytes_);
+}
+
+std::unique_ptr<PersistentRequest> CountingTransport::recvInit(int* data, int count,
+                                                               int source, int tag) {
+    return inner_->recvInit(data, count, source, tag);
+}
+
+void CountingTransport::broadcast(int* data, int count, int root) {
+    inner_->broadcast(data, count, root);
+}
+
+void CountingTransport::allreduceMin(std::uint64_t* data, int count) {
+    inner_->allreduceMin(data, count);
+}
+
+void CountingTransport::allreduceSum(std::uint64_t* data, int count) {
+    inner_->allreduceSum(data, count);
+}
+
+void CountingTransport::allreduceMax(double* data, int count) {
+    inner_->allreduceMax(data, count);
+}
+
+std::string CountingTransport::gatherBytes(const std::string& local, int root) {
+    return inner_->gatherBytes(local, root);
+}
+
+std::unique_ptr<SharedBoard> CountingTransport::allocateSharedBoard(int count) {
+    return inner_->allocateSharedBoard(count);
+}
+
+void CountingTransport::writeAtAll(const std::string& path, long long offset,
+                                   const int* data, int count, long long file_size) {
+    inner_->writeAtAll(path, offset, data, count, file_size);
+}
+
+void CountingTransport::resetCounters() {
+    messages_ = 0;
+    bytes_ = 0;
+}
+
+CaptureBenchmarkResult runCaptureBenchmark(std::shared_ptr<CaptureTransport> transport,
+                                           int num_cities, int repetitions,
+                                           const CaptureOptions& options,
+                                           const std::string& label) {
+    if (repetitions < 1) {
+        throw std::invalid_argument("Number of repetitions must be positive");
+    }
+    
+    auto counting = std::make_shared<CountingTransport>(transport);
+    
+    CaptureBenchmarkResult result;
+    result.label = label;
+    result.transport = transport->name();
+    result.mode = options.persistent ? "persistent" : "blocking";
+    if (options.shared_memory) {
+        result.mode += "+shm";
+    }
+    result.processes = transport->size();
+    result.cities = num_cities;
+    result.repetitions = repetitions;
+    result.valid = true;
+    
+    std::vector<double> times;
+    std::uint64_t traffic[2] = {0, 0};
+    
+    // Первый прогон - прогрев (установка соединений MPI, страницы памяти)
+    for (int rep = 0; rep <= repetitions; ++rep) {
+        counting->resetCounters();
+        
+        CityCapture capture(num_cities, options, counting);
+        capture.simulateCapture();
+        
+        // Счетчики снимаются до проверки: ее сообщения в замер не входят
+        std::uint64_t local_traffic[2] = {counting->messagesSent(), counting->bytesSent()};
+        bool valid = capture.validateResults();
+        
+        if (rep == 0) {
+            continue;
+        }
+        times.push_back(capture.getSimulationTime());
+        result.valid = result.valid && valid;
+        traffic[0] = local_traffic[0];
+        traffic[1] = local_traffic[1];
+    }
+    
+    // Трафик одного запуска, сумма по всем процессам
+    transport->allreduceSum(traffic, 2);
+    result.messages = traffic[0];
+    result.bytes = traffic[1];
+    
+    std::sort(times.begin(), times.end());
+    double median = times.size() % 2 == 1 ? times[times.size() / 2] :
+        (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2.0;
+    
+    result.median_ms = median * 1000.0;
+    result.min_ms = times.front() * 1000.0;
+    result.mean_step_us = median * 1e6 / num_cities;
+    result.messages_per_second = median > 0.0 ? result.messages / median : 0.0;
+    
+    return result;
+}
+
+void appendBenchmarkCSV(const std::vector<CaptureBenchmarkResult>& results,
+                        const std::string& filename) {
+    bool write_header;
+    {
+        std::ifstream existing(filename);
+        write_header = !existing.good() ||
+                       existing.peek() == std::ifstream::traits_type::eof();
+    }
+    
+    std::ofstream file(filename, std::ios::app);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open benchmark file: " + filename);
+    }
+    
+    if (write_header) {
+        file << "label,transport,mode,processes,cities,repetitions,median_ms,min_ms,"
+             << "mean_step_us,messages,bytes,messages_per_sec,valid\n";
+    }
+    
+    for (const auto& result : results) {
+        file << result.label << ","
+             << result.transport << ","
+             << result.mode << ","
+             << result.processes << ","
+             << result.cities << ","
+             << result.repetitions << ","
+             << std::fixed << std::setprecision(4) << result.median_ms << ","
+             << result.min_ms << ","
+             << std::setprecision(2) << result.mean_step_us << ","
+             << result.messages << ","
+             << result.bytes << ","
+             << std::setprecision(0) << result.messages_per_second << ","
+             << (result.valid ? 1 : 0) << "\n";
+    }
+}
+
+void appendBenchmarkJSON(const std::vector<CaptureBenchmarkResult>& results,
+                         const std::string& filename) {
+    std::ofstream file(filename, std::ios::app);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open benchmark file: " + filename);
+    }
+    
+    for (const auto& result : results) {
+        file << "{\"label\":\"" << result.label << "\""
+             << ",\"transport\":\"" << result.transport << "\""
+             << ",\"mode\":\"" << result.mode << "\""
+             << ",\"processes\":" << result.processes
+             << ",\"cities\":" << result.cities
+             << ",\"repetitions\":" << result.repetitions
+             << std::fixed << std::setprecision(4)
+             << ",\"median_ms\":" << result.median_ms
+             << ",\"min_ms\":" << result.min_ms
+             << std::setprecision(2)
+             << ",\"mean_step_us\":" << result.mean_step_us
+             << ",\"messages\":" << result.messages
+             << ",\"bytes\":" << result.bytes
+             << std::setprecision(0)
+             << ",\"messages_per_sec\":" << result.messages_per_second
+             << ",\"valid\":" << (result.valid ? "true" : "false") << "}\n";
+    }
+}
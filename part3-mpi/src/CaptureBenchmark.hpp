@@ -0,0 +1,81 @@
+#ifndef CAPTURE_BENCHMARK_HPP
+#define CAPTURE_BENCHMARK_HPP
+
+#include "CaptureTransport.hpp"
+#include "CityCapture.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Транспорт-обертка, считающий сообщения точка-точка текущего процесса
+class CountingTransport : public CaptureTransport {
+public:
+    explicit CountingTransport(std::shared_ptr<CaptureTransport> inner);
+    
+    int rank() const override { return inner_->rank(); }
+    int size() const override { return inner_->size(); }
+    double now() const override { return inner_->now(); }
+    
+    void send(const int* data, int count, int dest, int tag) override;
+    void recv(int* data, int count, int source, int tag) override;
+    
+    std::unique_ptr<PersistentRequest> sendInit(const int* data, int count,
+                                                int dest, int tag) override;
+    std::unique_ptr<PersistentRequest> recvInit(int* data, int count,
+                                                int source, int tag) override;
+    
+    void barrier() override { inner_->barrier(); }
+    void broadcast(int* data, int count, int root) override;
+    void allreduceMin(std::uint64_t* data, int count) override;
+    void allreduceSum(std::uint64_t* data, int count) override;
+    void allreduceMax(double* data, int count) override;
+    std::string gatherBytes(const std::string& local, int root) override;
+    std::unique_ptr<SharedBoard> allocateSharedBoard(int count) override;
+    void writeAtAll(const std::string& path, long long offset,
+                    const int* data, int count, long long file_size) override;
+    
+    std::string name() const override { return inner_->name(); }
+    
+    // Отправленные сообщения и байты с момента последнего сброса
+    std::uint64_t messagesSent() const { return messages_; }
+    std::uint64_t bytesSent() const { return bytes_; }
+    void resetCounters();
+    
+private:
+    std::shared_ptr<CaptureTransport> inner_;
+    std::uint64_t messages_;
+    std::uint64_t bytes_;
+};
+
+// Результат замера одной конфигурации (одинаков на всех процессах)
+struct CaptureBenchmarkResult {
+    std::string label;          // Метка запуска (например, коммит)
+    std::string transport;      // mpi или local
+    std::string mode;           // blocking или persistent, +shm - общая память
+    int processes = 0;
+    int cities = 0;
+    int repetitions = 0;
+    double median_ms = 0.0;     // Медиана времени симуляции
+    double min_ms = 0.0;
+    double mean_step_us = 0.0;       // Медиана, деленная на число шагов (не задержка шага)
+    std::uint64_t messages = 0;      // Сообщений за один запуск (все процессы)
+    std::uint64_t bytes = 0;
+    double messages_per_second = 0.0;
+    bool valid = false;         // Все повторы прошли проверку
+};
+
+// Прогон симуляции repetitions раз (плюс один прогрев) на заданном
+// транспорте. Вызывается всеми процессами транспорта
+CaptureBenchmarkResult runCaptureBenchmark(std::shared_ptr<CaptureTransport> transport,
+                                           int num_cities, int repetitions,
+                                           const CaptureOptions& options,
+                                           const std::string& label);
+
+// Дописывание результатов в CSV (заголовок - если файл новый) и в JSON
+// Lines (один объект на строку). Файлы можно копить между коммитами
+void appendBenchmarkCSV(const std::vector<CaptureBenchmarkResult>& results,
+                        const std::string& filename);
+void appendBenchmarkJSON(const std::vector<CaptureBenchmarkResult>& results,
+                         const std::string& filename);
+
+#endif // CAPTURE_BENCHMARK_HPP
@@ -0,0 +1,87 @@
+#ifndef CAPTURE_TRANSPORT_HPP
+#define CAPTURE_TRANSPORT_HPP
+
+#include <string>
+#include <cstdint>
+#include <memory>
+
+// Постоянный запрос: буфер, партнер и тег задаются один раз, затем
+// обмен многократно запускается start() и завершается wait().
+// Буфер нельзя менять между start() и wait()
+class PersistentRequest {
+public:
+    virtual ~PersistentRequest() = default;
+    
+    virtual void start() = 0;
+    virtual void wait() = 0;
+};
+
+// Массив int в общей памяти узла, размещенный у ранга 0. Процессы того же
+// узла читают его напрямую; запись становится видимой после sync() у
+// писателя, барьера и sync() у читателя
+class SharedBoard {
+public:
+    virtual ~SharedBoard() = default;
+    
+    // Доступен ли массив этому процессу
+    virtual bool isLocal() const = 0;
+    
+    // Работает ли процесс rank на одном узле с рангом 0
+    virtual bool sharedWith(int rank) const = 0;
+    
+    // Указатель на массив (nullptr, если он недоступен)
+    virtual int* data() = 0;
+    
+    // Синхронизация памяти процесса с общим массивом
+    virtual void sync() = 0;
+};
+
+// Интерфейс обмена данными для CityCapture. Семантика повторяет
+// используемое подмножество MPI: сообщения между парой процессов с одним
+// тегом доставляются по порядку, коллективные операции вызываются всеми
+// процессами в одинаковом порядке.
+class CaptureTransport {
+public:
+    virtual ~CaptureTransport() = default;
+    
+    // Ранг процесса и количество процессов
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+    
+    // Текущее время в секундах (для замеров)
+    virtual double now() const = 0;
+    
+    // Блокирующие сообщения точка-точка
+    virtual void send(const int* data, int count, int dest, int tag) = 0;
+    virtual void recv(int* data, int count, int source, int tag) = 0;
+    
+    // Постоянные запросы для повторяющихся сообщений одной формы
+    virtual std::unique_ptr<PersistentRequest> sendInit(const int* data, int count,
+                                                        int dest, int tag) = 0;
+    virtual std::unique_ptr<PersistentRequest> recvInit(int* data, int count,
+                                                        int source, int tag) = 0;
+    
+    // Коллективные операции
+    virtual void barrier() = 0;
+    virtual void broadcast(int* data, int count, int root) = 0;
+    virtual void allreduceMin(std::uint64_t* data, int count) = 0;
+    virtual void allreduceSum(std::uint64_t* data, int count) = 0;
+    virtual void allreduceMax(double* data, int count) = 0;
+    
+    // Сбор байтовых буферов на root (конкатенация по порядку рангов)
+    virtual std::string gatherBytes(const std::string& local, int root) = 0;
+    
+    // Коллективное выделение общего для узла массива из count int
+    // (заполнен нулями)
+    virtual std::unique_ptr<SharedBoard> allocateSharedBoard(int count) = 0;
+    
+    // Коллективная запись: файл обрезается до file_size байт,
+    // каждый процесс пишет count значений по своему смещению
+    virtual void writeAtAll(const std::string& path, long long offset,
+                            const int* data, int count, long long file_size) = 0;
+    
+    // Название реализации для вывода
+    virtual std::string name() const = 0;
+};
+
+#endif // CAPTURE_TRANSPORT_HPP
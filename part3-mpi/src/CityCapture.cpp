@@ -5,240 +5,876 @@
 #include <random>
 #include <chrono>
 #include <sstream>
-#include <mpi.h>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
 
-CityCapture::CityCapture(int num_cities) 
-    : num_cities_(num_cities) {
+namespace {
+
+// Теги сообщений протокола захвата
+constexpr int TAG_CAPTURE = 0;        // Командующий -> город: захват на шаге
+constexpr int TAG_CIPHER_PART = 1;    // Город -> командующий: своя часть шифра
+constexpr int TAG_KNOWN_PARTS = 2;    // Командующий -> новый город: собранные части
+constexpr int TAG_NEW_PART = 3;       // Командующий -> захваченные города: новая часть
+constexpr int TAG_COMPLETE = 99;      // Город -> командующий: полный шифр
+constexpr int TAG_VALIDATE = 101;     // Город -> командующий: размер шифра
+
+// Верхняя граница числа городов (шагов). Процесс может вести несколько
+// городов, поэтому граница не связана с числом процессов
+constexpr int MAX_CITIES = 2000;
+
+// Формат файла контрольной точки
+constexpr std::uint32_t CHECKPOINT_MAGIC = 0x504B4343;  // "CCKP"
+constexpr std::uint32_t CHECKPOINT_VERSION = 2;
+
+void writeInts(std::ofstream& out, const std::vector<int>& values) {
+    std::uint32_t size = static_cast<std::uint32_t>(values.size());
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char*>(values.data()), size * sizeof(int));
+}
+
+bool readInts(std::ifstream& in, std::vector<int>& values) {
+    std::uint32_t size = 0;
+    if (!in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+        return false;
+    }
+    values.resize(size);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(values.data()), size * sizeof(int)));
+}
+
+// Потоки счетчикового генератора
+constexpr std::uint64_t STREAM_CIPHER = 1;
+constexpr std::uint64_t STREAM_ORDER = 2;
+
+// Финализатор SplitMix64: хорошее перемешивание 64-битного счетчика
+std::uint64_t mix64(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warning: return "WARN";
+        default: return "";
+    }
+}
+
+} // namespace
+
+// Сообщение формируется только если уровень проходит фильтр;
+// при CITY_CAPTURE_NO_LOGGING вызов исчезает целиком
+#ifdef CITY_CAPTURE_NO_LOGGING
+#define CITY_LOG(level, message) do { } while (0)
+#else
+#define CITY_LOG(level, message) \
+    do { if (shouldLog(level)) logEvent(level, message); } while (0)
+#endif
+
+CityCapture::CityCapture(int num_cities, const CaptureOptions& options,
+                         std::shared_ptr<CaptureTransport> transport)
+    : num_cities_(num_cities), transport_(std::move(transport)), options_(options),
+      hosted_first_(1), hosted_count_(0), start_step_(0), completed_steps_(0),
+      simulation_time_(0.0), checkpoint_time_(0.0), checkpoints_written_(0),
+      output_time_(0.0) {
     
-    MPI_Comm_size(MPI_COMM_WORLD, &world_size_);
-    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank_);
+    world_size_ = transport_->size();
+    world_rank_ = transport_->rank();
     
-    if (world_rank_ == 0) {
+    // В мире из одного процесса объект создается, но симуляция невозможна:
+    // городам нужен хотя бы один процесс кроме командующего (см. simulateCapture)
+    if (world_rank_ > 0) {
+        hosted_first_ = firstCityOf(world_rank_);
+        hosted_count_ = cityCountOf(world_rank_);
+    }
+    
+    if (world_rank_ == 0 && !options_.quiet) {
         std::cout << "=== City Capture Simulation ===" << std::endl;
         std::cout << "Number of cities: " << num_cities_ << std::endl;
-        std::cout << "MPI processes: " << world_size_ << std::endl;
+        std::cout << "Processes: " << world_size_ << " (" << transport_->name()
+                  << " transport)" << std::endl;
+        
+        if (world_size_ < 2) {
+            std::cerr << "Warning: no city processes, simulation needs at least 2" << std::endl;
+        } else if (world_size_ < num_cities_ + 1) {
+            std::cout << "Up to " << cityCountOf(1) << " cities per process" << std::endl;
+        } else if (world_size_ > num_cities_ + 1) {
+            std::cout << (world_size_ - num_cities_ - 1)
+                      << " process(es) have no city and only join collective steps" << std::endl;
+        }
         
-        if (world_size_ != num_cities_ + 1) {
-            std::cerr << "Warning: Need exactly " << (num_cities_ + 1) 
-                      << " MPI processes (cities + commander)" << std::endl;
+        if (checkpointingEnabled()) {
+            std::cout << "Checkpoints: every " << options_.checkpoint_interval
+                      << " step(s) in " << options_.checkpoint_dir << std::endl;
         }
     }
 }
 
 void CityCapture::simulateCapture() {
+    if (world_size_ < 2) {
+        throw std::runtime_error("City capture needs at least 2 processes (commander + city)");
+    }
+    
+    double start_time = transport_->now();
+    
+    if (options_.restart) {
+        start_step_ = restoreCheckpoint();
+    }
+    completed_steps_ = start_step_;
+    
+    if (options_.shared_memory) {
+        board_ = transport_->allocateSharedBoard(num_cities_);
+    }
+    
+    // Процессы без городов тоже проходят шаги: барьеры коллективные
     if (world_rank_ == 0) {
         masterProcess();
-    } else if (world_rank_ <= num_cities_) {
-        cityProcess();
     } else {
-        // Лишние процессы не участвуют
-        if (world_rank_ == world_size_ - 1) {
-            std::cout << "Process " << world_rank_ << " is idle (not needed)" << std::endl;
-        }
+        cityProcess();
     }
     
-    MPI_Barrier(MPI_COMM_WORLD);
+    // Освобождение окна - коллективная операция
+    board_.reset();
+    
+    // Коллективная запись матрицы шифров: участвуют все процессы
+    if (!options_.output_file.empty() && runsToCompletion()) {
+        writeCipherMatrix();
+    }
+    
+    transport_->barrier();
+    
+    // Максимальное время по всем процессам
+    double times[3] = {transport_->now() - start_time, checkpoint_time_, output_time_};
+    transport_->allreduceMax(times, 3);
+    simulation_time_ = times[0];
+    checkpoint_time_ = times[1];
+    output_time_ = times[2];
+    
+    flushLog();
 }
 
 void CityCapture::masterProcess() {
-    std::cout << "\nCommander process starting simulation..." << std::endl;
-    
-    // Создаем порядок захвата городов (случайная перестановка)
-    std::vector<int> capture_order(num_cities_);
-    for (int i = 0; i < num_cities_; ++i) {
-        capture_order[i] = i + 1; // Города нумеруются с 1
+    if (!options_.quiet) {
+        std::cout << "\nCommander process starting simulation..." << std::endl;
     }
     
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(capture_order.begin(), capture_order.end(), g);
+    if (start_step_ > 0) {
+        if (!options_.quiet) {
+            std::cout << "Resuming from checkpoint after step " << start_step_ << std::endl;
+        }
+    } else {
+        // Создаем порядок захвата городов (случайная перестановка)
+        capture_order_ = generateCaptureOrder();
+    }
     
-    std::cout << "\nCapture order: ";
-    for (int city : capture_order) {
-        std::cout << city << " ";
+    if (!options_.quiet) {
+        std::cout << "\nCapture order: ";
+        for (int city : capture_order_) {
+            std::cout << city << " ";
+        }
+        std::cout << std::endl;
     }
-    std::cout << std::endl;
     
     // Отправляем порядок захвата всем городам
-    MPI_Bcast(capture_order.data(), num_cities_, MPI_INT, 0, MPI_COMM_WORLD);
+    transport_->broadcast(capture_order_.data(), num_cities_, 0);
     
-    // Симуляция захвата городов
-    std::vector<int> captured_cities;
-    std::vector<int> all_ciphers(num_cities_);
+    // После восстановления доска заполняется сохраненными частями
+    if (board_ && start_step_ > 0) {
+        std::copy(cipher_parts_.begin(), cipher_parts_.end(), board_->data());
+        board_->sync();
+        transport_->barrier();
+    }
     
-    for (int step = 0; step < num_cities_; ++step) {
-        int current_city = capture_order[step];
-        
-        logEvent("Step " + std::to_string(step + 1) + 
-                 ": Capturing city " + std::to_string(current_city));
+    // Процессы, у которых уже есть захваченные города (адресаты новых частей).
+    // Процессы на узле командующего читают части с доски и не оповещаются
+    std::vector<char> notified(world_size_, 0);
+    std::vector<int> notified_hosts;
+    for (int host = 1; host < world_size_; ++host) {
+        notified[host] = readsBoard(host) ? 1 : 0;
+    }
+    for (int i = 0; i < start_step_; ++i) {
+        int host = hostOf(capture_order_[i]);
+        if (!notified[host]) {
+            notified[host] = 1;
+            notified_hosts.push_back(host);
+        }
+    }
+    
+    // Постоянные запросы для сообщений фиксированной формы: по одному
+    // на процесс городов и тип сообщения, создаются до начала шагов
+    int step_buffer = 0;
+    int part_buffer = 0;
+    int new_part_buffer = 0;
+    std::vector<std::unique_ptr<PersistentRequest>> capture_requests(world_size_);
+    std::vector<std::unique_ptr<PersistentRequest>> part_requests(world_size_);
+    std::vector<std::unique_ptr<PersistentRequest>> new_part_requests(world_size_);
+    if (options_.persistent) {
+        for (int host = 1; host < world_size_; ++host) {
+            if (cityCountOf(host) == 0) {
+                continue;
+            }
+            capture_requests[host] = transport_->sendInit(&step_buffer, 1, host, TAG_CAPTURE);
+            part_requests[host] = transport_->recvInit(&part_buffer, 1, host, TAG_CIPHER_PART);
+            if (!readsBoard(host)) {
+                new_part_requests[host] = transport_->sendInit(&new_part_buffer, 1, host,
+                                                               TAG_NEW_PART);
+            }
+        }
+    }
+    
+    // Симуляция захвата городов: cipher_parts_ командующего хранит части
+    // в порядке захвата (часть шага i - в позиции i)
+    for (int step = start_step_; step < num_cities_; ++step) {
+        int current_city = capture_order_[step];
+        int current_host = hostOf(current_city);
         
-        // Оповещаем город о захвате
-        MPI_Send(&step, 1, MPI_INT, current_city, 0, MPI_COMM_WORLD);
+        CITY_LOG(LogLevel::Info, "Step " + std::to_string(step + 1) +
+                                 ": Capturing city " + std::to_string(current_city));
         
-        // Получаем часть шифра от захваченного города
+        // Оповещаем город о захвате и получаем от него часть шифра
+        // (в постоянном режиме прием размещается заранее)
         int cipher_part;
-        MPI_Recv(&cipher_part, 1, MPI_INT, current_city, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        
-        logEvent("Received cipher part " + std::to_string(cipher_part) +
-                 " from city " + std::to_string(current_city));
+        if (options_.persistent) {
+            step_buffer = step;
+            part_requests[current_host]->start();
+            capture_requests[current_host]->start();
+            capture_requests[current_host]->wait();
+            part_requests[current_host]->wait();
+            cipher_part = part_buffer;
+        } else {
+            transport_->send(&step, 1, current_host, TAG_CAPTURE);
+            transport_->recv(&cipher_part, 1, current_host, TAG_CIPHER_PART);
+        }
         
-        // Сохраняем часть шифра
-        all_ciphers[step] = cipher_part;
+        CITY_LOG(LogLevel::Debug, "Received cipher part " + std::to_string(cipher_part) +
+                                  " from city " + std::to_string(current_city));
         
-        // Отправляем всем уже захваченным городам новую часть шифра
-        for (int captured_city : captured_cities) {
-            MPI_Send(&cipher_part, 1, MPI_INT, captured_city, 
-                    2 + step, MPI_COMM_WORLD);
+        // Передаем новому городу все ранее собранные части
+        if (step > 0 && !readsBoard(current_host)) {
+            transport_->send(cipher_parts_.data(), step, current_host, TAG_KNOWN_PARTS);
         }
         
-        // Получаем от первого захваченного города новую часть шифра
-        if (!captured_cities.empty()) {
-            int new_cipher_part;
-            MPI_Recv(&new_cipher_part, 1, MPI_INT, captured_cities[0], 
-                    3 + step, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            
-            logEvent("First city " + std::to_string(captured_cities[0]) +
-                     " sent new cipher part " + std::to_string(new_cipher_part));
-            
-            // Рассылаем новую часть всем захваченным городам
-            for (int captured_city : captured_cities) {
-                if (captured_city != captured_cities[0]) {
-                    MPI_Send(&new_cipher_part, 1, MPI_INT, captured_city, 
-                            4 + step, MPI_COMM_WORLD);
-                }
+        // Отправляем новую часть шифра процессам с уже захваченными
+        // городами: одно сообщение на процесс, а не на город. Постоянные
+        // отправки запускаются все сразу и завершаются вместе
+        if (options_.persistent) {
+            new_part_buffer = cipher_part;
+            for (int host : notified_hosts) {
+                new_part_requests[host]->start();
+            }
+            for (int host : notified_hosts) {
+                new_part_requests[host]->wait();
+            }
+        } else {
+            for (int host : notified_hosts) {
+                transport_->send(&cipher_part, 1, host, TAG_NEW_PART);
             }
-            
-            // Отправляем новую часть текущему городу
-            MPI_Send(&new_cipher_part, 1, MPI_INT, current_city, 
-                    5 + step, MPI_COMM_WORLD);
         }
         
-        captured_cities.push_back(current_city);
+        if (!notified[current_host]) {
+            notified[current_host] = 1;
+            notified_hosts.push_back(current_host);
+        }
+        
+        // Сохраняем часть шифра (и публикуем ее на доске)
+        cipher_parts_.push_back(cipher_part);
+        if (board_) {
+            board_->data()[step] = cipher_part;
+            board_->sync();
+        }
         
         // Небольшая задержка для реалистичности
-        MPI_Barrier(MPI_COMM_WORLD);
+        transport_->barrier();
+        
+        completed_steps_ = step + 1;
+        maybeCheckpoint(step);
+        if (haltAfter(step)) {
+            std::cout << "\n=== Simulation halted after step " << (step + 1)
+                      << " ===" << std::endl;
+            return;
+        }
+    }
+    
+    // При выводе через MPI-IO города пишут свои строки сами,
+    // матрица не проходит через командующего
+    if (!options_.output_file.empty()) {
+        if (!options_.quiet) {
+            std::cout << "\n=== Simulation Complete ===" << std::endl;
+        }
+        return;
     }
     
     // Собираем полные шифры от всех городов
     std::vector<int> complete_ciphers(num_cities_ * num_cities_);
     for (int i = 1; i <= num_cities_; ++i) {
         std::vector<int> city_cipher(num_cities_);
-        MPI_Recv(city_cipher.data(), num_cities_, MPI_INT, i, 
-                99, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        transport_->recv(city_cipher.data(), num_cities_, hostOf(i), TAG_COMPLETE);
         
-        std::copy(city_cipher.begin(), city_cipher.end(), 
+        std::copy(city_cipher.begin(), city_cipher.end(),
                   complete_ciphers.begin() + (i - 1) * num_cities_);
     }
     
-    // Отправляем сигнал о завершении всем городам
-    int finish_signal = -1;
-    for (int i = 1; i <= num_cities_; ++i) {
-        MPI_Send(&finish_signal, 1, MPI_INT, i, 100, MPI_COMM_WORLD);
+    if (!options_.quiet) {
+        std::cout << "\n=== Simulation Complete ===" << std::endl;
     }
-    
-    std::cout << "\n=== Simulation Complete ===" << std::endl;
 }
 
 void CityCapture::cityProcess() {
-    int city_id = world_rank_;
-    
-    logEvent("City " + std::to_string(city_id) + " initialized");
+    CITY_LOG(LogLevel::Debug, "Cities " + std::to_string(hosted_first_) + ".." +
+                              std::to_string(hosted_first_ + hosted_count_ - 1) + " initialized");
     
     // Получаем порядок захвата
-    std::vector<int> capture_order(num_cities_);
-    MPI_Bcast(capture_order.data(), num_cities_, MPI_INT, 0, MPI_COMM_WORLD);
+    capture_order_.resize(num_cities_);
+    transport_->broadcast(capture_order_.data(), num_cities_, 0);
     
-    // Генерируем свою часть шифра
-    int my_cipher_part = generateCipherPart(city_id);
-    cipher_parts_.push_back(my_cipher_part);
+    if (board_ && start_step_ > 0) {
+        transport_->barrier();
+    }
+    bool use_board = readsBoard(world_rank_);
     
-    // Ждем команды от командующего
-    while (true) {
-        int step;
-        MPI_Recv(&step, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        
-        if (step == -1) { // Сигнал завершения
-            break;
+    // Генерируем части шифра своих городов (при восстановлении они уже есть)
+    if (city_parts_.empty()) {
+        city_parts_.resize(hosted_count_);
+        for (int k = 0; k < hosted_count_; ++k) {
+            city_parts_[k].push_back(generateCipherPart(hosted_first_ + k));
+        }
+    }
+    
+    // Свои города, захваченные до текущего шага (индексы в city_parts_)
+    std::vector<int> captured;
+    for (int step = 0; step < start_step_; ++step) {
+        if (isHosted(capture_order_[step])) {
+            captured.push_back(capture_order_[step] - hosted_first_);
+        }
+    }
+    
+    // Постоянные запросы (создаются один раз, перезапускаются на шагах)
+    int captured_at = 0;
+    int part_buffer = 0;
+    int new_cipher_part = 0;
+    std::unique_ptr<PersistentRequest> capture_request;
+    std::unique_ptr<PersistentRequest> part_request;
+    std::unique_ptr<PersistentRequest> new_part_request;
+    if (options_.persistent && hosted_count_ > 0) {
+        capture_request = transport_->recvInit(&captured_at, 1, 0, TAG_CAPTURE);
+        part_request = transport_->sendInit(&part_buffer, 1, 0, TAG_CIPHER_PART);
+        if (!use_board) {
+            new_part_request = transport_->recvInit(&new_cipher_part, 1, 0, TAG_NEW_PART);
         }
+    }
+    
+    for (int step = start_step_; step < num_cities_; ++step) {
+        int current_city = capture_order_[step];
         
-        // Проверяем, наш ли это ход захвата
-        int current_city = capture_order[step];
+        // Прием новой части размещается заранее, до обработки захвата
+        bool expects_new_part = !use_board && !captured.empty();
+        if (expects_new_part && new_part_request) {
+            new_part_request->start();
+        }
         
-        if (current_city == city_id) {
-            // Нас захватывают
-            logEvent("City " + std::to_string(city_id) + " captured at step " + 
-                     std::to_string(step + 1));
-            
-            // Отправляем нашу часть шифра командующему
-            MPI_Send(&my_cipher_part, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);
-            
-            // Ждем получения всех частей шифра
-            for (int i = 0; i < step; ++i) {
-                int cipher_part;
-                MPI_Recv(&cipher_part, 1, MPI_INT, 0, 2 + step, 
-                        MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-                cipher_parts_.push_back(cipher_part);
+        if (isHosted(current_city)) {
+            // Наш город захватывают: ждем команды от командующего
+            std::vector<int>& parts = city_parts_[current_city - hosted_first_];
+            if (capture_request) {
+                capture_request->start();
+                capture_request->wait();
+            } else {
+                transport_->recv(&captured_at, 1, 0, TAG_CAPTURE);
             }
             
-            // Если мы первый захваченный город, отправляем новую часть шифра
-            if (step == 0) {
-                int new_cipher_part = generateCipherPart(city_id * 100 + step);
-                MPI_Send(&new_cipher_part, 1, MPI_INT, 0, 3 + step, MPI_COMM_WORLD);
+            CITY_LOG(LogLevel::Info, "City " + std::to_string(current_city) +
+                                     " captured at step " + std::to_string(captured_at + 1));
+            
+            // Отправляем часть шифра города командующему
+            if (part_request) {
+                part_buffer = parts.front();
+                part_request->start();
+                part_request->wait();
             } else {
-                // Ждем новую часть от первого города
-                int new_cipher_part;
-                MPI_Recv(&new_cipher_part, 1, MPI_INT, 0, 4 + step, 
-                        MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-                cipher_parts_.push_back(new_cipher_part);
+                transport_->send(&parts.front(), 1, 0, TAG_CIPHER_PART);
             }
-        } else {
-            // Нас уже захватили ранее
-            // Получаем часть шифра от нового города
-            int new_cipher_part;
-            MPI_Recv(&new_cipher_part, 1, MPI_INT, 0, 2 + step, 
-                    MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            cipher_parts_.push_back(new_cipher_part);
             
-            // Если мы первый город, отправляем новую часть
-            if (city_id == capture_order[0]) {
-                int our_new_part = generateCipherPart(city_id * 100 + step);
-                MPI_Send(&our_new_part, 1, MPI_INT, 0, 3 + step, MPI_COMM_WORLD);
+            // Получаем все части, собранные до него
+            if (step > 0 && !use_board) {
+                std::vector<int> known_parts(step);
+                transport_->recv(known_parts.data(), step, 0, TAG_KNOWN_PARTS);
+                parts.insert(parts.end(), known_parts.begin(), known_parts.end());
+            }
+        }
+        
+        // Города, захваченные ранее, получают часть нового города
+        // (одно сообщение на процесс)
+        if (expects_new_part) {
+            if (new_part_request) {
+                new_part_request->wait();
             } else {
-                // Получаем новую часть от первого города
-                int newest_cipher_part;
-                MPI_Recv(&newest_cipher_part, 1, MPI_INT, 0, 4 + step, 
-                        MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-                cipher_parts_.push_back(newest_cipher_part);
+                transport_->recv(&new_cipher_part, 1, 0, TAG_NEW_PART);
+            }
+            for (int k : captured) {
+                city_parts_[k].push_back(new_cipher_part);
+            }
+        }
+        
+        transport_->barrier();
+        
+        // На узле командующего части читаются с доски после барьера
+        if (use_board) {
+            board_->sync();
+            const int* board = board_->data();
+            for (int k : captured) {
+                city_parts_[k].push_back(board[step]);
             }
+            if (isHosted(current_city)) {
+                std::vector<int>& parts = city_parts_[current_city - hosted_first_];
+                parts.insert(parts.end(), board, board + step);
+            }
+        }
+        
+        if (isHosted(current_city)) {
+            captured.push_back(current_city - hosted_first_);
         }
         
-        MPI_Barrier(MPI_COMM_WORLD);
+        completed_steps_ = step + 1;
+        maybeCheckpoint(step);
+        if (haltAfter(step)) {
+            return;
+        }
     }
     
-    // Отправляем полный шифр командующему
-    MPI_Send(cipher_parts_.data(), cipher_parts_.size(), MPI_INT, 0, 99, MPI_COMM_WORLD);
-    
-    logEvent("City " + std::to_string(city_id) + " complete cipher size: " + 
-             std::to_string(cipher_parts_.size()));
+    // Отправляем полные шифры командующему (если они не пишутся в файл)
+    for (int k = 0; k < hosted_count_; ++k) {
+        if (options_.output_file.empty()) {
+            transport_->send(city_parts_[k].data(), static_cast<int>(city_parts_[k].size()),
+                             0, TAG_COMPLETE);
+        }
+        
+        CITY_LOG(LogLevel::Info, "City " + std::to_string(hosted_first_ + k) +
+                                 " complete cipher size: " +
+                                 std::to_string(city_parts_[k].size()));
+    }
 }
 
 int CityCapture::generateCipherPart(int city_id) const {
+    if (isSeeded()) {
+        return static_cast<int>(seededHash(STREAM_CIPHER, city_id) % 1000 + 1000);
+    }
+    
     // Генерация уникальной части шифра на основе ID города
     std::hash<int> hasher;
     auto timestamp = std::chrono::system_clock::now().time_since_epoch().count();
     return static_cast<int>((hasher(city_id) ^ hasher(timestamp)) % 1000 + 1000);
 }
 
-void CityCapture::logEvent(const std::string& event) const {
+// Блочное распределение: первые n % W процессов получают на один город больше
+int CityCapture::firstCityOf(int rank) const {
+    int workers = world_size_ - 1;
+    int base = num_cities_ / workers;
+    int extra = num_cities_ % workers;
+    int index = rank - 1;
+    return 1 + index * base + std::min(index, extra);
+}
+
+int CityCapture::cityCountOf(int rank) const {
+    int workers = world_size_ - 1;
+    int index = rank - 1;
+    return num_cities_ / workers + (index < num_cities_ % workers ? 1 : 0);
+}
+
+int CityCapture::hostOf(int city) const {
+    int workers = world_size_ - 1;
+    int base = num_cities_ / workers;
+    int extra = num_cities_ % workers;
+    int index = city - 1;
+    
+    // Первые extra блоков длиной base + 1, остальные - base
+    if (index < extra * (base + 1)) {
+        return 1 + index / (base + 1);
+    }
+    return 1 + extra + (index - extra * (base + 1)) / base;
+}
+
+bool CityCapture::isHosted(int city) const {
+    return world_rank_ > 0 && city >= hosted_first_ && city < hosted_first_ + hosted_count_;
+}
+
+std::uint64_t CityCapture::seededHash(std::uint64_t stream, std::uint64_t counter) const {
+    return mix64(mix64(static_cast<std::uint64_t>(options_.seed) ^ (stream << 56)) + counter);
+}
+
+std::vector<int> CityCapture::generateCaptureOrder() const {
+    std::vector<int> order(num_cities_);
+    for (int i = 0; i < num_cities_; ++i) {
+        order[i] = i + 1; // Города нумеруются с 1
+    }
+    
+    if (isSeeded()) {
+        // Тасование Фишера-Йетса со счетчиковым хешем вместо ГСЧ
+        for (int i = num_cities_ - 1; i > 0; --i) {
+            int j = static_cast<int>(seededHash(STREAM_ORDER, i) % (i + 1));
+            std::swap(order[i], order[j]);
+        }
+    } else {
+        std::random_device rd;
+        std::mt19937 g(rd());
+        std::shuffle(order.begin(), order.end(), g);
+    }
+    
+    return order;
+}
+
+std::uint64_t CityCapture::cipherChecksum(const std::vector<int>& parts) {
+    // Сумма перемешанных значений: не зависит от порядка частей
+    std::uint64_t checksum = 0;
+    for (int part : parts) {
+        checksum += mix64(static_cast<std::uint64_t>(static_cast<std::uint32_t>(part)));
+    }
+    return checksum;
+}
+
+std::uint64_t CityCapture::expectedCipherChecksum() const {
+    std::vector<int> parts(num_cities_);
+    for (int city = 1; city <= num_cities_; ++city) {
+        parts[city - 1] = generateCipherPart(city);
+    }
+    return cipherChecksum(parts);
+}
+
+bool CityCapture::shouldLog(LogLevel level) const {
+    return level >= options_.log_level && options_.log_level != LogLevel::Off &&
+           (world_rank_ == 0 || hosted_count_ > 0);
+}
+
+void CityCapture::logEvent(LogLevel level, const std::string& event) const {
+    std::stringstream ss;
+    if (world_rank_ == 0) {
+        ss << "[Commander] ";
+    } else if (hosted_count_ == 1) {
+        ss << "[City " << std::setw(2) << hosted_first_ << "] ";
+    } else {
+        ss << "[Rank " << std::setw(2) << world_rank_ << "] ";
+    }
+    if (level != LogLevel::Info) {
+        ss << logLevelName(level) << ": ";
+    }
+    ss << event << '\n';
+    
+    if (options_.log_mode == LogMode::Immediate) {
+        std::cout << ss.str() << std::flush;
+    } else {
+        log_buffer_ += ss.str();
+    }
+}
+
+// Вывод накопленного журнала. В режиме Buffered буферы собираются на
+// командующем (MPI_Gatherv) и печатаются по порядку рангов
+// (коллективная операция), в режиме PerRankFile каждый процесс пишет свой файл
+void CityCapture::flushLog() {
+#ifndef CITY_CAPTURE_NO_LOGGING
+    if (options_.log_mode == LogMode::PerRankFile) {
+        if (!log_buffer_.empty()) {
+            std::ofstream out(options_.log_prefix + ".rank" +
+                              std::to_string(world_rank_) + ".log", std::ios::app);
+            out << log_buffer_;
+        }
+    } else if (options_.log_mode == LogMode::Buffered) {
+        std::string all_logs = transport_->gatherBytes(log_buffer_, 0);
+        
+        if (world_rank_ == 0 && !all_logs.empty()) {
+            std::cout << "\n=== Event Log ===\n" << all_logs << std::flush;
+        }
+    }
+#endif
+    log_buffer_.clear();
+}
+
+bool CityCapture::checkpointingEnabled() const {
+    return !options_.checkpoint_dir.empty() && options_.checkpoint_interval > 0;
+}
+
+bool CityCapture::haltAfter(int step) const {
+    return options_.halt_after_step >= 0 && step >= options_.halt_after_step &&
+           step + 1 < num_cities_;
+}
+
+std::string CityCapture::checkpointFile(int completed_steps, int rank) const {
+    return options_.checkpoint_dir + "/city_capture_step" +
+           std::to_string(completed_steps) + "_rank" + std::to_string(rank) + ".ckpt";
+}
+
+std::string CityCapture::checkpointMetaFile() const {
+    return options_.checkpoint_dir + "/city_capture.meta";
+}
+
+void CityCapture::maybeCheckpoint(int step) {
+    int completed = step + 1;
+    if (!checkpointingEnabled() || completed >= num_cities_ ||
+        completed % options_.checkpoint_interval != 0) {
+        return;
+    }
+    
+    double start = transport_->now();
+    writeCheckpoint(completed);
+    checkpoint_time_ += transport_->now() - start;
+    ++checkpoints_written_;
+}
+
+// Координированная контрольная точка: каждый процесс параллельно пишет свой
+// файл, после барьера командующий фиксирует номер шага в meta-файле.
+// Файлы предыдущей контрольной точки удаляются только после фиксации новой.
+void CityCapture::writeCheckpoint(int completed_steps) {
+    int previous_steps = completed_steps - options_.checkpoint_interval;
+    
+    {
+        std::ofstream out(checkpointFile(completed_steps, world_rank_), std::ios::binary);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot write checkpoint: " +
+                                     checkpointFile(completed_steps, world_rank_));
+        }
+        
+        std::uint32_t header[6] = {
+            CHECKPOINT_MAGIC, CHECKPOINT_VERSION,
+            static_cast<std::uint32_t>(world_rank_),
+            static_cast<std::uint32_t>(world_size_),
+            static_cast<std::uint32_t>(num_cities_),
+            static_cast<std::uint32_t>(completed_steps)
+        };
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        writeInts(out, capture_order_);
+        
+        // Командующий хранит один набор, процесс городов - по набору на город
+        if (world_rank_ == 0) {
+            writeInts(out, cipher_parts_);
+        } else {
+            for (const auto& parts : city_parts_) {
+                writeInts(out, parts);
+            }
+        }
+    }
+    
+    // Все процессы записали свои файлы
+    transport_->barrier();
+    
+    if (world_rank_ == 0) {
+        std::string meta = checkpointMetaFile();
+        std::string tmp = meta + ".tmp";
+        {
+            std::ofstream out(tmp);
+            out << completed_steps << " " << num_cities_ << "\n";
+        }
+        std::rename(tmp.c_str(), meta.c_str());
+        
+        CITY_LOG(LogLevel::Info, "Checkpoint saved after step " + std::to_string(completed_steps));
+    }
+    
+    // Meta-файл переименован: до этого барьера сбой оставил бы его
+    // указывающим на предыдущую точку, поэтому ее файлы еще нужны
+    transport_->barrier();
+    
+    if (previous_steps > 0) {
+        std::remove(checkpointFile(previous_steps, world_rank_).c_str());
+    }
+}
+
+// Восстановление состояния: командующий читает зафиксированный шаг и
+// рассылает его, каждый процесс загружает свой файл. Возвращает шаг начала.
+int CityCapture::restoreCheckpoint() {
+    int completed_steps = 0;
+    
+    if (world_rank_ == 0 && !options_.checkpoint_dir.empty()) {
+        std::ifstream meta(checkpointMetaFile());
+        int saved_cities = 0;
+        if (meta >> completed_steps >> saved_cities) {
+            if (saved_cities != num_cities_) {
+                std::cerr << "Checkpoint is for " << saved_cities
+                          << " cities, starting from scratch" << std::endl;
+                completed_steps = 0;
+            }
+        } else {
+            completed_steps = 0;
+        }
+    }
+    
+    transport_->broadcast(&completed_steps, 1, 0);
+    
+    // Распределение городов зависит от числа процессов, поэтому
+    // восстановление возможно только при том же количестве процессов
+    int loaded = 1;
+    if (completed_steps > 0) {
+        std::ifstream in(checkpointFile(completed_steps, world_rank_), std::ios::binary);
+        std::uint32_t header[6] = {0, 0, 0, 0, 0, 0};
+        std::vector<int> order;
+        std::vector<std::vector<int>> sets(world_rank_ == 0 ? 1 : hosted_count_);
+        
+        loaded = in.read(reinterpret_cast<char*>(header), sizeof(header)) &&
+                 header[0] == CHECKPOINT_MAGIC && header[1] == CHECKPOINT_VERSION &&
+                 header[2] == static_cast<std::uint32_t>(world_rank_) &&
+                 header[3] == static_cast<std::uint32_t>(world_size_) &&
+                 header[4] == static_cast<std::uint32_t>(num_cities_) &&
+                 header[5] == static_cast<std::uint32_t>(completed_steps) &&
+                 readInts(in, order) && static_cast<int>(order.size()) == num_cities_;
+        
+        for (auto& parts : sets) {
+            loaded = loaded && readInts(in, parts);
+        }
+        
+        if (loaded) {
+            capture_order_ = order;
+            if (world_rank_ == 0) {
+                cipher_parts_ = sets[0];
+            } else {
+                city_parts_ = sets;
+            }
+        }
+    }
+    
+    // Продолжаем только если все процессы успешно загрузили состояние
+    std::uint64_t all_loaded = loaded;
+    transport_->allreduceMin(&all_loaded, 1);
+    
+    if (!all_loaded) {
+        if (world_rank_ == 0) {
+            std::cerr << "Incomplete checkpoint after step " << completed_steps
+                      << ", starting from scratch" << std::endl;
+        }
+        capture_order_.clear();
+        cipher_parts_.clear();
+        city_parts_.clear();
+        return 0;
+    }
+    
+    return completed_steps;
+}
+
+bool CityCapture::runsToCompletion() const {
+    // Одинаково вычисляется на всех процессах, включая процессы без городов
+    return options_.halt_after_step < 0 || options_.halt_after_step + 1 >= num_cities_;
+}
+
+// Каждый процесс записывает строки своих городов (непрерывный блок) по
+// своему смещению в общий файл, командующий и процессы без городов участвуют
+// в коллективной операции с нулевым объемом
+void CityCapture::writeCipherMatrix() {
+    double start = transport_->now();
+    
+    long long row_bytes = static_cast<long long>(num_cities_) * sizeof(int);
+    
+    // Незаполненные части строк остаются нулевыми, как и при set_size
+    std::vector<int> rows(static_cast<size_t>(hosted_count_) * num_cities_, 0);
+    for (int k = 0; k < hosted_count_; ++k) {
+        int count = std::min(static_cast<int>(city_parts_[k].size()), num_cities_);
+        std::copy_n(city_parts_[k].begin(), count, rows.begin() + k * num_cities_);
+    }
+    long long offset = hosted_count_ > 0 ? (hosted_first_ - 1) * row_bytes : 0;
+    
+    transport_->writeAtAll(options_.output_file, offset, rows.data(),
+                           static_cast<int>(rows.size()), row_bytes * num_cities_);
+    
+    output_time_ = transport_->now() - start;
+    
     if (world_rank_ == 0) {
-        std::cout << "[Commander] " << event << std::endl;
-    } else if (world_rank_ <= num_cities_) {
-        std::stringstream ss;
-        ss << "[City " << std::setw(2) << world_rank_ << "] " << event;
-        std::cout << ss.str() << std::endl;
+        CITY_LOG(LogLevel::Info, "Cipher matrix written to " + options_.output_file);
+    }
+}
+
+// Разбор аргументов командной строки: число городов и параметры симуляции.
+// Неизвестный флаг, флаг без значения или нечисловой позиционный аргумент -
+// ошибка: печатается справка, бросается std::invalid_argument
+void CityCapture::parseCommandLine(int argc, char* argv[], int& num_cities,
+                                   CaptureOptions& options, bool verbose) {
+    auto fail = [&](const std::string& message) {
+        if (verbose) {
+            std::cerr << message << "\n" << usage(argc > 0 ? argv[0] : "city_capture");
+        }
+        throw std::invalid_argument(message);
+    };
+    
+    // Флаги со значением: следующий аргумент обязателен
+    auto value = [&](int& i, const std::string& flag) -> std::string {
+        if (i + 1 >= argc) {
+            fail("Missing value for " + flag);
+        }
+        return argv[++i];
+    };
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        
+        if (arg == "--checkpoint-dir") {
+            options.checkpoint_dir = value(i, arg);
+        } else if (arg == "--checkpoint-interval") {
+            options.checkpoint_interval = std::atoi(value(i, arg).c_str());
+        } else if (arg == "--output") {
+            options.output_file = value(i, arg);
+        } else if (arg == "--log-level") {
+            std::string level = value(i, arg);
+            options.log_level = level == "debug" ? LogLevel::Debug :
+                                level == "warning" ? LogLevel::Warning :
+                                level == "off" ? LogLevel::Off : LogLevel::Info;
+        } else if (arg == "--log-mode") {
+            std::string mode = value(i, arg);
+            options.log_mode = mode == "immediate" ? LogMode::Immediate :
+                               mode == "files" ? LogMode::PerRankFile : LogMode::Buffered;
+        } else if (arg == "--seed") {
+            options.seed = std::atoll(value(i, arg).c_str());
+        } else if (arg == "--validation") {
+            std::string mode = value(i, arg);
+            options.validation = mode == "allreduce" ? ValidationMode::Allreduce :
+                                                       ValidationMode::PointToPoint;
+        } else if (arg == "--restart") {
+            options.restart = true;
+        } else if (arg == "--persistent") {
+            options.persistent = true;
+        } else if (arg == "--shared-memory") {
+            options.shared_memory = true;
+        } else if (arg == "--halt-after") {
+            options.halt_after_step = std::atoi(value(i, arg).c_str()) - 1;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            fail("Unknown option: " + arg);
+        } else {
+            // Число городов задает только позиционное целое
+            char* end = nullptr;
+            long count = std::strtol(arg.c_str(), &end, 10);
+            if (arg.empty() || *end != '\0') {
+                fail("Invalid argument: " + arg);
+            }
+            if (count < 2 || count > MAX_CITIES) {
+                if (verbose) {
+                    std::cerr << "Invalid number of cities. Using default: 20" << std::endl;
+                }
+                count = 20;
+            }
+            num_cities = static_cast<int>(count);
+        }
+    }
+    
+    if (!options.checkpoint_dir.empty() && options.checkpoint_interval <= 0) {
+        options.checkpoint_interval = 1;
     }
 }
 
+std::string CityCapture::usage(const std::string& program) {
+    std::ostringstream out;
+    out << "Usage: " << program << " [num_cities] [options]\n"
+        << "  --checkpoint-dir <dir>       Directory for checkpoints\n"
+        << "  --checkpoint-interval <n>    Steps between checkpoints\n"
+        << "  --restart                    Resume from the latest checkpoint\n"
+        << "  --halt-after <step>          Stop after the given step\n"
+        << "  --output <file>              Write the cipher matrix with MPI-IO\n"
+        << "  --log-level <level>          debug, info, warning or off\n"
+        << "  --log-mode <mode>            buffered, immediate or files\n"
+        << "  --seed <n>                   Seed for the capture order\n"
+        << "  --validation <mode>          p2p or allreduce\n"
+        << "  --persistent                 Persistent requests for broadcasts\n"
+        << "  --shared-memory              Shared cipher board within a node\n";
+    return out.str();
+}
+
 std::map<int, std::vector<int>> CityCapture::getCaptureResults() const {
     // Этот метод вызывается только из главного процесса после симуляции
     std::map<int, std::vector<int>> results;
@@ -257,34 +893,108 @@ void CityCapture::printResults() const {
     if (world_rank_ == 0) {
         std::cout << "\n=== Final Results ===" << std::endl;
         std::cout << "All cities should now have complete cipher." << std::endl;
+        std::cout << "Simulation time: " << std::fixed << std::setprecision(3)
+                  << simulation_time_ * 1000.0 << " ms" << std::endl;
+        
+        if (checkpointingEnabled()) {
+            double overhead = simulation_time_ > 0.0 ?
+                checkpoint_time_ / simulation_time_ * 100.0 : 0.0;
+            std::cout << "Checkpoints written: " << checkpoints_written_
+                      << ", overhead: " << checkpoint_time_ * 1000.0 << " ms ("
+                      << std::setprecision(1) << overhead << "%)" << std::endl;
+        }
+        
+        if (!options_.output_file.empty()) {
+            std::cout << "Cipher matrix: " << options_.output_file << " ("
+                      << std::setprecision(3) << output_time_ * 1000.0 << " ms)" << std::endl;
+        }
     }
 }
 
 bool CityCapture::validateResults() const {
+    if (options_.validation == ValidationMode::Allreduce) {
+        return validateAllreduce();
+    }
+    return validatePointToPoint();
+}
+
+bool CityCapture::validatePointToPoint() const {
+    bool all_complete = false;
+    
     if (world_rank_ == 0) {
         // Главный процесс проверяет, что все города получили полный шифр
         std::vector<int> cipher_sizes(num_cities_);
         
         for (int i = 1; i <= num_cities_; ++i) {
-            MPI_Recv(&cipher_sizes[i-1], 1, MPI_INT, i, 101, 
-                    MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            transport_->recv(&cipher_sizes[i-1], 1, hostOf(i), TAG_VALIDATE);
         }
         
-        bool all_complete = true;
+        all_complete = true;
         for (int size : cipher_sizes) {
             if (size != num_cities_) {
                 all_complete = false;
                 break;
             }
         }
-        
-        return all_complete;
-    } else if (world_rank_ <= num_cities_) {
+    } else {
         // Города отправляют размер своего шифра
-        int cipher_size = cipher_parts_.size();
-        MPI_Send(&cipher_size, 1, MPI_INT, 0, 101, MPI_COMM_WORLD);
-        return cipher_size == num_cities_;
+        all_complete = true;
+        for (const auto& parts : city_parts_) {
+            int cipher_size = parts.size();
+            transport_->send(&cipher_size, 1, 0, TAG_VALIDATE);
+            all_complete = all_complete && cipher_size == num_cities_;
+        }
+    }
+    
+    // При заданном зерне содержимое известно заранее: каждый город сверяет
+    // контрольную сумму своего набора, результаты сводятся по всем процессам
+    if (isSeeded()) {
+        std::uint64_t content_ok = 1;
+        if (!city_parts_.empty()) {
+            std::uint64_t expected = expectedCipherChecksum();
+            for (const auto& parts : city_parts_) {
+                content_ok = content_ok && cipherChecksum(parts) == expected;
+            }
+        }
+        
+        transport_->allreduceMin(&content_ok, 1);
+        all_complete = all_complete && content_ok;
+    }
+    
+    return all_complete;
+}
+
+// Каждый город вносит контрольную сумму своего набора и его размер;
+// один MPI_Allreduce(MIN) по {h, ~h, size, ~size} дает минимум и максимум
+// сразу. Наборы совпадают, если min(h) == max(h) и все размеры равны n.
+// Результат одинаков на всех процессах.
+bool CityCapture::validateAllreduce() const {
+    const std::uint64_t neutral = ~std::uint64_t(0);
+    std::uint64_t global[4] = {neutral, neutral, neutral, neutral};
+    
+    for (const auto& parts : city_parts_) {
+        std::uint64_t checksum = cipherChecksum(parts);
+        std::uint64_t size = parts.size();
+        global[0] = std::min(global[0], checksum);
+        global[1] = std::min(global[1], ~checksum);
+        global[2] = std::min(global[2], size);
+        global[3] = std::min(global[3], ~size);
+    }
+    
+    transport_->allreduceMin(global, 4);
+    
+    std::uint64_t min_checksum = global[0];
+    std::uint64_t max_checksum = ~global[1];
+    std::uint64_t min_size = global[2];
+    std::uint64_t max_size = ~global[3];
+    
+    bool identical = min_checksum == max_checksum &&
+                     min_size == static_cast<std::uint64_t>(num_cities_) &&
+                     max_size == static_cast<std::uint64_t>(num_cities_);
+    
+    if (identical && isSeeded()) {
+        identical = min_checksum == expectedCipherChecksum();
     }
     
-    return false;
+    return identical;
 }
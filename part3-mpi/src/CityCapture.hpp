@@ -5,11 +5,75 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <cstdint>
+#include "CaptureTransport.hpp"
+
+// Уровни журнала событий
+enum class LogLevel { Debug = 0, Info = 1, Warning = 2, Off = 3 };
+
+// Режим вывода журнала: сразу в stdout, буфер процесса с выводом в конце
+// симуляции (по порядку рангов) или буфер с записью в файл процесса
+enum class LogMode { Immediate, Buffered, PerRankFile };
+
+// Проверка результатов: размеры шифров отправляются командующему
+// (O(n) сообщений на нем) или все города сверяют контрольные суммы
+// своих наборов одним MPI_Allreduce (O(log n))
+enum class ValidationMode { PointToPoint, Allreduce };
+
+// Параметры симуляции
+struct CaptureOptions {
+    // Контрольные точки: каталог для файлов (пусто - отключено)
+    std::string checkpoint_dir;
+    
+    // Контрольная точка каждые N шагов (0 - отключено)
+    int checkpoint_interval = 0;
+    
+    // Продолжить с последней завершенной контрольной точки
+    bool restart = false;
+    
+    // Остановить симуляцию после указанного шага (имитация сбоя, -1 - нет)
+    int halt_after_step = -1;
+    
+    // Файл для полной матрицы шифров (пусто - не сохранять). Каждый город
+    // коллективно записывает свою строку через MPI-IO: num_cities строк
+    // по num_cities значений int, строка города i по смещению (i-1)*n*sizeof(int)
+    std::string output_file;
+    
+    // Журнал событий. При сборке с CITY_CAPTURE_NO_LOGGING журнал
+    // удаляется полностью, включая формирование сообщений
+    LogLevel log_level = LogLevel::Info;
+    LogMode log_mode = LogMode::Buffered;
+    std::string log_prefix = "city_capture";  // Файлы <prefix>.rank<N>.log
+    
+    // Зерно для воспроизводимых запусков (-1 - случайный порядок и шифры).
+    // Порядок захвата и части шифра выводятся счетчиковым хешем от зерна,
+    // что позволяет проверять содержимое шифров, а не только размеры
+    long long seed = -1;
+    
+    // Способ проверки результатов
+    ValidationMode validation = ValidationMode::PointToPoint;
+    
+    // Не печатать ход симуляции командующего (для замеров производительности)
+    bool quiet = false;
+    
+    // Постоянные запросы (MPI_Send_init/MPI_Recv_init) для сообщений
+    // фиксированной формы: захват, часть шифра, новая часть
+    bool persistent = false;
+    
+    // Части шифра для городов на узле командующего передаются через общую
+    // память (MPI_Win_allocate_shared), остальным - сообщениями
+    bool shared_memory = false;
+};
 
 class CityCapture {
 public:
     // Конструктор принимает количество городов (должно быть 20)
-    CityCapture(int num_cities = 20);
+    CityCapture(int num_cities = 20, const CaptureOptions& options = CaptureOptions());
+    
+    // Конструктор с явным транспортом (MPI или локальные потоки). Нужно
+    // не менее двух процессов; при нехватке процесс ведет несколько городов
+    CityCapture(int num_cities, const CaptureOptions& options,
+                std::shared_ptr<CaptureTransport> transport);
     
     // Запуск симуляции захвата городов
     void simulateCapture();
@@ -26,14 +90,58 @@ public:
     // Проверка корректности результатов
     bool validateResults() const;
     
+    // Разбор аргументов командной строки (общий для MPI и локального режима)
+    static void parseCommandLine(int argc, char* argv[], int& num_cities,
+                                 CaptureOptions& options, bool verbose);
+    
+    // Справка по аргументам командной строки
+    static std::string usage(const std::string& program);
+    
+    // Шаг, с которого началась симуляция (0 или шаг контрольной точки)
+    int getStartStep() const { return start_step_; }
+    
+    // Количество завершенных шагов захвата
+    int getCompletedSteps() const { return completed_steps_; }
+    
+    // Время симуляции и накладные расходы на контрольные точки (секунды,
+    // максимум по всем процессам)
+    double getSimulationTime() const { return simulation_time_; }
+    double getCheckpointTime() const { return checkpoint_time_; }
+    int getCheckpointsWritten() const { return checkpoints_written_; }
+    
+    // Время коллективной записи матрицы шифров (секунды)
+    double getOutputTime() const { return output_time_; }
+    
 private:
     int num_cities_;                    // Количество городов (20)
-    int world_size_;                    // Общее количество MPI процессов
+    std::shared_ptr<CaptureTransport> transport_;  // Обмен данными
+    int world_size_;                    // Общее количество процессов
     int world_rank_;                    // Ранг текущего процесса
+    CaptureOptions options_;            // Параметры симуляции
     
     // Данные процесса (города)
     std::vector<int> captured_cities_;  // Захваченные города данным процессом
-    std::vector<int> cipher_parts_;     // Части шифра у данного города
+    std::vector<int> cipher_parts_;     // Части шифра, собранные командующим
+    std::vector<int> capture_order_;    // Порядок захвата городов
+    
+    // Города распределяются по процессам 1..P-1 непрерывными блоками,
+    // поэтому симуляция работает при любом количестве процессов
+    int hosted_first_;                  // Первый город процесса
+    int hosted_count_;                  // Количество городов процесса
+    std::vector<std::vector<int>> city_parts_;  // Части шифра каждого города
+    
+    // Общая для узла доска частей шифра в порядке захвата (часть шага i -
+    // в позиции i), существует только во время simulateCapture
+    std::unique_ptr<SharedBoard> board_;
+    bool readsBoard(int rank) const { return board_ && board_->sharedWith(rank); }
+    
+    // Состояние выполнения
+    int start_step_;                    // Шаг начала (после восстановления)
+    int completed_steps_;               // Завершенные шаги
+    double simulation_time_;            // Время симуляции
+    double checkpoint_time_;            // Время записи контрольных точек
+    int checkpoints_written_;           // Количество контрольных точек
+    double output_time_;                // Время записи матрицы шифров
     
     // Метод для главного процесса
     void masterProcess();
@@ -44,10 +152,45 @@ private:
     // Генерация части шифра для города
     int generateCipherPart(int city_id) const;
     
+    // Распределение городов по процессам
+    int firstCityOf(int rank) const;
+    int cityCountOf(int rank) const;
+    int hostOf(int city) const;
+    bool isHosted(int city) const;
+    
+    // Детерминированная генерация (при заданном зерне)
+    bool isSeeded() const { return options_.seed >= 0; }
+    std::uint64_t seededHash(std::uint64_t stream, std::uint64_t counter) const;
+    std::vector<int> generateCaptureOrder() const;
+    
+    // Варианты проверки результатов
+    bool validatePointToPoint() const;
+    bool validateAllreduce() const;
+    
+    // Контрольная сумма набора частей шифра (не зависит от порядка)
+    static std::uint64_t cipherChecksum(const std::vector<int>& parts);
+    std::uint64_t expectedCipherChecksum() const;
+    
     // Логирование события
-    void logEvent(const std::string& event) const;
+    mutable std::string log_buffer_;    // Буфер журнала процесса
+    bool shouldLog(LogLevel level) const;
+    void logEvent(LogLevel level, const std::string& event) const;
+    void flushLog();
+    
+    // Контрольные точки
+    bool checkpointingEnabled() const;
+    bool haltAfter(int step) const;
+    void maybeCheckpoint(int step);
+    void writeCheckpoint(int completed_steps);
+    int restoreCheckpoint();
+    std::string checkpointFile(int completed_steps, int rank) const;
+    std::string checkpointMetaFile() const;
+    
+    // Параллельный вывод матрицы шифров (MPI-IO)
+    bool runsToCompletion() const;
+    void writeCipherMatrix();
     
-    // Вспомогательные методы MPI
+    // Вспомогательные методы обмена
     void broadcastToAllCities(const std::vector<int>& data, int tag);
     void gatherFromAllCities(std::vector<int>& data, int tag);
     void sendCipherPart(int dest_city, int cipher_part);
@@ -0,0 +1,347 @@
+#include "LocalTransport.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+SpscQueue::SpscQueue(size_t capacity)
+    : head_(0), tail_(0) {
+    
+    // Размер - степень двойки, чтобы позиция бралась маской
+    size_t size = 64;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+}
+
+bool SpscQueue::tryPush(int tag, const int* data, int count) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t needed = static_cast<size_t>(count) + 2;
+    
+    if (buffer_.size() - (tail - head) < needed) {
+        return false;
+    }
+    
+    buffer_[tail & mask_] = tag;
+    buffer_[(tail + 1) & mask_] = count;
+    for (int i = 0; i < count; ++i) {
+        buffer_[(tail + 2 + i) & mask_] = data[i];
+    }
+    
+    // Публикуем сообщение целиком одной записью позиции
+    tail_.store(tail + needed, std::memory_order_release);
+    return true;
+}
+
+bool SpscQueue::tryPop(int& tag, std::vector<int>& data) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    
+    if (head == tail) {
+        return false;
+    }
+    
+    tag = buffer_[head & mask_];
+    int count = buffer_[(head + 1) & mask_];
+    data.resize(count);
+    for (int i = 0; i < count; ++i) {
+        data[i] = buffer_[(head + 2 + i) & mask_];
+    }
+    
+    head_.store(head + count + 2, std::memory_order_release);
+    return true;
+}
+
+LocalFabric::LocalFabric(int size, int max_message)
+    : int_slots(size), u64_slots(size), double_slots(size), byte_slots(size),
+      size_(size), barrier_count_(0), barrier_phase_(0), aborted_(false) {
+    
+    size_t capacity = std::max<size_t>(1024, 4 * (static_cast<size_t>(max_message) + 2));
+    channels_.reserve(static_cast<size_t>(size) * size);
+    for (int i = 0; i < size * size; ++i) {
+        channels_.push_back(std::make_unique<SpscQueue>(capacity));
+    }
+}
+
+void LocalFabric::barrier() {
+    int phase = barrier_phase_.load(std::memory_order_acquire);
+    
+    if (barrier_count_.fetch_add(1, std::memory_order_acq_rel) == size_ - 1) {
+        // Последний пришедший открывает следующую фазу
+        barrier_count_.store(0, std::memory_order_relaxed);
+        barrier_phase_.store(phase + 1, std::memory_order_release);
+        return;
+    }
+    
+    while (barrier_phase_.load(std::memory_order_acquire) == phase) {
+        checkAborted();
+        std::this_thread::yield();
+    }
+}
+
+void LocalFabric::checkAborted() const {
+    if (aborted_.load(std::memory_order_acquire)) {
+        throw std::runtime_error("Local run aborted: another rank failed");
+    }
+}
+
+void LocalFabric::run(int size, int max_message,
+                      const std::function<void(std::shared_ptr<CaptureTransport>)>& body) {
+    auto fabric = std::make_shared<LocalFabric>(size, max_message);
+    
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    std::vector<std::thread> threads;
+    threads.reserve(size);
+    
+    for (int rank = 0; rank < size; ++rank) {
+        threads.emplace_back([&, rank]() {
+            try {
+                body(std::make_shared<LocalTransport>(fabric, rank));
+            } catch (...) {
+                // Первая ошибка запоминается до abort(): исключения
+                // прерванных рангов ее не заменят
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                fabric->abort();
+            }
+        });
+    }
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+LocalTransport::LocalTransport(std::shared_ptr<LocalFabric> fabric, int rank)
+    : fabric_(std::move(fabric)), rank_(rank), pending_(fabric_->size()) {}
+
+double LocalTransport::now() const {
+    auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(since_epoch).count();
+}
+
+void LocalTransport::send(const int* data, int count, int dest, int tag) {
+    SpscQueue& queue = fabric_->channel(rank_, dest);
+    if (static_cast<size_t>(count) + 2 > queue.capacity()) {
+        throw std::length_error("Message does not fit into local channel");
+    }
+    
+    while (!queue.tryPush(tag, data, count)) {
+        fabric_->checkAborted();
+        std::this_thread::yield();
+    }
+}
+
+void LocalTransport::recv(int* data, int count, int source, int tag) {
+    auto& pending = pending_[source];
+    
+    // Сначала ищем среди отложенных сообщений этого отправителя
+    auto it = std::find_if(pending.begin(), pending.end(),
+                           [tag](const auto& message) { return message.first == tag; });
+    if (it != pending.end()) {
+        std::copy_n(it->second.begin(), std::min<size_t>(count, it->second.size()), data);
+        pending.erase(it);
+        return;
+    }
+    
+    SpscQueue& queue = fabric_->channel(source, rank_);
+    int message_tag;
+    std::vector<int> message;
+    while (true) {
+        if (!queue.tryPop(message_tag, message)) {
+            fabric_->checkAborted();
+            std::this_thread::yield();
+            continue;
+        }
+        if (message_tag == tag) {
+            std::copy_n(message.begin(), std::min<size_t>(count, message.size()), data);
+            return;
+        }
+        pending.emplace_back(message_tag, std::move(message));
+    }
+}
+
+namespace {
+
+// Эмуляция постоянного запроса: отправка выполняется при start()
+// (очередь буферизует сообщение), прием - при wait()
+class LocalPersistentRequest : public PersistentRequest {
+public:
+    LocalPersistentRequest(LocalTransport& transport, bool is_send, int* data,
+                           int count, int peer, int tag)
+        : transport_(transport), is_send_(is_send), data_(data),
+          count_(count), peer_(peer), tag_(tag) {}
+    
+    void start() override {
+        if (is_send_) {
+            transport_.send(data_, count_, peer_, tag_);
+        }
+    }
+    
+    void wait() override {
+        if (!is_send_) {
+            transport_.recv(data_, count_, peer_, tag_);
+        }
+    }
+    
+private:
+    LocalTransport& transport_;
+    bool is_send_;
+    int* data_;
+    int count_;
+    int peer_;
+    int tag_;
+};
+
+} // namespace
+
+std::unique_ptr<PersistentRequest> LocalTransport::sendInit(const int* data, int count,
+                                                            int dest, int tag) {
+    return std::make_unique<LocalPersistentRequest>(*this, true, const_cast<int*>(data),
+                                                    count, dest, tag);
+}
+
+std::unique_ptr<PersistentRequest> LocalTransport::recvInit(int* data, int count,
+                                                            int source, int tag) {
+    return std::make_unique<LocalPersistentRequest>(*this, false, data, count, source, tag);
+}
+
+void LocalTransport::barrier() {
+    fabric_->barrier();
+}
+
+// Коллективные операции: запись в свой слот, барьер, чтение, барьер
+// (второй барьер защищает слоты от следующей операции)
+void LocalTransport::broadcast(int* data, int count, int root) {
+    if (rank_ == root) {
+        fabric_->int_slots[root].assign(data, data + count);
+    }
+    fabric_->barrier();
+    if (rank_ != root) {
+        std::copy_n(fabric_->int_slots[root].begin(), count, data);
+    }
+    fabric_->barrier();
+}
+
+void LocalTransport::allreduceMin(std::uint64_t* data, int count) {
+    fabric_->u64_slots[rank_].assign(data, data + count);
+    fabric_->barrier();
+    for (int r = 0; r < fabric_->size(); ++r) {
+        for (int i = 0; i < count; ++i) {
+            data[i] = std::min(data[i], fabric_->u64_slots[r][i]);
+        }
+    }
+    fabric_->barrier();
+}
+
+void LocalTransport::allreduceSum(std::uint64_t* data, int count) {
+    fabric_->u64_slots[rank_].assign(data, data + count);
+    fabric_->barrier();
+    std::fill_n(data, count, 0);
+    for (int r = 0; r < fabric_->size(); ++r) {
+        for (int i = 0; i < count; ++i) {
+            data[i] += fabric_->u64_slots[r][i];
+        }
+    }
+    fabric_->barrier();
+}
+
+void LocalTransport::allreduceMax(double* data, int count) {
+    fabric_->double_slots[rank_].assign(data, data + count);
+    fabric_->barrier();
+    for (int r = 0; r < fabric_->size(); ++r) {
+        for (int i = 0; i < count; ++i) {
+            data[i] = std::max(data[i], fabric_->double_slots[r][i]);
+        }
+    }
+    fabric_->barrier();
+}
+
+std::string LocalTransport::gatherBytes(const std::string& local, int root) {
+    fabric_->byte_slots[rank_] = local;
+    fabric_->barrier();
+    std::string all;
+    if (rank_ == root) {
+        for (const auto& bytes : fabric_->byte_slots) {
+            all += bytes;
+        }
+    }
+    fabric_->barrier();
+    return all;
+}
+
+namespace {
+
+// Все потоки процесса видят общий массив; порядок записей обеспечивает
+// барьер (атомарные операции acquire/release), sync() - полный барьер памяти
+class LocalSharedBoard : public SharedBoard {
+public:
+    explicit LocalSharedBoard(int* data) : data_(data) {}
+    
+    bool isLocal() const override { return true; }
+    bool sharedWith(int) const override { return true; }
+    int* data() override { return data_; }
+    
+    void sync() override {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    
+private:
+    int* data_;
+};
+
+} // namespace
+
+std::unique_ptr<SharedBoard> LocalTransport::allocateSharedBoard(int count) {
+    // Первый барьер: прежний массив больше никто не читает
+    fabric_->barrier();
+    if (rank_ == 0) {
+        fabric_->board.assign(count, 0);
+    }
+    fabric_->barrier();
+    return std::make_unique<LocalSharedBoard>(fabric_->board.data());
+}
+
+void LocalTransport::writeAtAll(const std::string& path, long long offset,
+                                const int* data, int count, long long file_size) {
+    // Ранг 0 создает файл нужного размера, затем все пишут свои части
+    bool failed = false;
+    if (rank_ == 0) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+        failed = fd < 0 || ::ftruncate(fd, file_size) != 0;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    fabric_->barrier();
+    
+    if (count > 0) {
+        int fd = ::open(path.c_str(), O_WRONLY);
+        size_t bytes = static_cast<size_t>(count) * sizeof(int);
+        failed = fd < 0 || ::pwrite(fd, data, bytes, offset) != static_cast<ssize_t>(bytes);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    fabric_->barrier();
+    
+    if (failed) {
+        throw std::runtime_error("Cannot write output file: " + path);
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef LOCAL_TRANSPORT_HPP
+#define LOCAL_TRANSPORT_HPP
+
+#include "CaptureTransport.hpp"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Очередь без блокировок для одного писателя и одного читателя.
+// Кольцевой буфер int с сообщениями вида [tag, count, data...]
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity);
+    
+    // Запись сообщения целиком (false - нет места)
+    bool tryPush(int tag, const int* data, int count);
+    
+    // Чтение сообщения целиком (false - очередь пуста)
+    bool tryPop(int& tag, std::vector<int>& data);
+    
+    size_t capacity() const { return buffer_.size(); }
+    
+private:
+    std::vector<int> buffer_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;  // Позиция читателя
+    alignas(64) std::atomic<size_t> tail_;  // Позиция писателя
+};
+
+// Общая память процессов-потоков: очередь на каждую пару (отправитель,
+// получатель) и буферы коллективных операций
+class LocalFabric {
+public:
+    // max_message - наибольшее сообщение в int (определяет размер очередей)
+    LocalFabric(int size, int max_message);
+    
+    int size() const { return size_; }
+    
+    SpscQueue& channel(int source, int dest) { return *channels_[source * size_ + dest]; }
+    
+    // Барьер с обращением фазы, ожидание через yield
+    void barrier();
+    
+    // Сбой одного ранга: ожидающие в барьере и очередях прерываются
+    // исключением, иначе run() не дождался бы завершения потоков
+    void abort() { aborted_.store(true, std::memory_order_release); }
+    void checkAborted() const;
+    
+    // Слоты для обмена в коллективных операциях
+    std::vector<std::vector<int>> int_slots;
+    std::vector<std::vector<std::uint64_t>> u64_slots;
+    std::vector<std::vector<double>> double_slots;
+    std::vector<std::string> byte_slots;
+    
+    // Общий массив частей шифра (все потоки на одном "узле")
+    std::vector<int> board;
+    
+    // Запуск body в отдельном потоке на каждый ранг
+    static void run(int size, int max_message,
+                    const std::function<void(std::shared_ptr<CaptureTransport>)>& body);
+                    
+private:
+    int size_;
+    std::vector<std::unique_ptr<SpscQueue>> channels_;
+    std::atomic<int> barrier_count_;
+    std::atomic<int> barrier_phase_;
+    std::atomic<bool> aborted_;
+};
+
+// Обмен внутри одного процесса: ранги - потоки, общая LocalFabric
+class LocalTransport : public CaptureTransport {
+public:
+    LocalTransport(std::shared_ptr<LocalFabric> fabric, int rank);
+    
+    int rank() const override { return rank_; }
+    int size() const override { return fabric_->size(); }
+    double now() const override;
+    
+    void send(const int* data, int count, int dest, int tag) override;
+    void recv(int* data, int count, int source, int tag) override;
+    
+    std::unique_ptr<PersistentRequest> sendInit(const int* data, int count,
+                                                int dest, int tag) override;
+    std::unique_ptr<PersistentRequest> recvInit(int* data, int count,
+                                                int source, int tag) override;
+    
+    void barrier() override;
+    void broadcast(int* data, int count, int root) override;
+    void allreduceMin(std::uint64_t* data, int count) override;
+    void allreduceSum(std::uint64_t* data, int count) override;
+    void allreduceMax(double* data, int count) override;
+    std::string gatherBytes(const std::string& local, int root) override;
+    std::unique_ptr<SharedBoard> allocateSharedBoard(int count) override;
+    void writeAtAll(const std::string& path, long long offset,
+                    const int* data, int count, long long file_size) override;
+    
+    std::string name() const override { return "local"; }
+    
+private:
+    std::shared_ptr<LocalFabric> fabric_;
+    int rank_;
+    
+    // Сообщения, пришедшие раньше ожидаемого тега (по отправителям).
+    // Принадлежат только получателю, синхронизация не нужна
+    std::vector<std::deque<std::pair<int, std::vector<int>>>> pending_;
+};
+
+#endif // LOCAL_TRANSPORT_HPP
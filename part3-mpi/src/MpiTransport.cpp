@@ -0,0 +1,215 @@
+#include "MpiTransport.hpp"
+#include "CityCapture.hpp"
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+MpiTransport::MpiTransport(MPI_Comm comm)
+    : comm_(comm) {
+    
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &size_);
+}
+
+double MpiTransport::now() const {
+    return MPI_Wtime();
+}
+
+void MpiTransport::send(const int* data, int count, int dest, int tag) {
+    MPI_Send(data, count, MPI_INT, dest, tag, comm_);
+}
+
+void MpiTransport::recv(int* data, int count, int source, int tag) {
+    MPI_Recv(data, count, MPI_INT, source, tag, comm_, MPI_STATUS_IGNORE);
+}
+
+namespace {
+
+// MPI_Send_init / MPI_Recv_init: запрос создается один раз и
+// перезапускается MPI_Start на каждом шаге
+class MpiPersistentRequest : public PersistentRequest {
+public:
+    explicit MpiPersistentRequest(MPI_Request request) : request_(request) {}
+    
+    ~MpiPersistentRequest() override {
+        MPI_Request_free(&request_);
+    }
+    
+    void start() override {
+        MPI_Start(&request_);
+    }
+    
+    void wait() override {
+        MPI_Wait(&request_, MPI_STATUS_IGNORE);
+    }
+    
+private:
+    MPI_Request request_;
+};
+
+} // namespace
+
+std::unique_ptr<PersistentRequest> MpiTransport::sendInit(const int* data, int count,
+                                                          int dest, int tag) {
+    MPI_Request request;
+    MPI_Send_init(data, count, MPI_INT, dest, tag, comm_, &request);
+    return std::make_unique<MpiPersistentRequest>(request);
+}
+
+std::unique_ptr<PersistentRequest> MpiTransport::recvInit(int* data, int count,
+                                                          int source, int tag) {
+    MPI_Request request;
+    MPI_Recv_init(data, count, MPI_INT, source, tag, comm_, &request);
+    return std::make_unique<MpiPersistentRequest>(request);
+}
+
+void MpiTransport::barrier() {
+    MPI_Barrier(comm_);
+}
+
+void MpiTransport::broadcast(int* data, int count, int root) {
+    MPI_Bcast(data, count, MPI_INT, root, comm_);
+}
+
+void MpiTransport::allreduceMin(std::uint64_t* data, int count) {
+    MPI_Allreduce(MPI_IN_PLACE, data, count, MPI_UINT64_T, MPI_MIN, comm_);
+}
+
+void MpiTransport::allreduceSum(std::uint64_t* data, int count) {
+    MPI_Allreduce(MPI_IN_PLACE, data, count, MPI_UINT64_T, MPI_SUM, comm_);
+}
+
+void MpiTransport::allreduceMax(double* data, int count) {
+    MPI_Allreduce(MPI_IN_PLACE, data, count, MPI_DOUBLE, MPI_MAX, comm_);
+}
+
+// Размеры собираются MPI_Gather, сами буферы - одним MPI_Gatherv
+std::string MpiTransport::gatherBytes(const std::string& local, int root) {
+    int local_size = static_cast<int>(local.size());
+    std::vector<int> sizes(rank_ == root ? size_ : 0);
+    MPI_Gather(&local_size, 1, MPI_INT, sizes.data(), 1, MPI_INT, root, comm_);
+    
+    std::vector<int> offsets(sizes.size(), 0);
+    std::string all;
+    if (rank_ == root) {
+        int total = 0;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            offsets[i] = total;
+            total += sizes[i];
+        }
+        all.resize(total);
+    }
+    
+    MPI_Gatherv(local.data(), local_size, MPI_CHAR,
+                &all[0], sizes.data(), offsets.data(), MPI_CHAR, root, comm_);
+    return all;
+}
+
+namespace {
+
+// Окно MPI_Win_allocate_shared на узловом коммуникаторе
+// (MPI_Comm_split_type с MPI_COMM_TYPE_SHARED). Память выделяет только
+// ранг 0, процессы его узла получают указатель через MPI_Win_shared_query.
+// Пассивная эпоха MPI_Win_lock_all открыта на все время жизни окна.
+class MpiSharedBoard : public SharedBoard {
+public:
+    MpiSharedBoard(MPI_Comm comm, int count)
+        : data_(nullptr), local_(false) {
+        
+        int rank, size;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &size);
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm_);
+        
+        // Номер ранга 0 в узловом коммуникаторе (MPI_UNDEFINED - другой узел)
+        MPI_Group group, node_group;
+        MPI_Comm_group(comm, &group);
+        MPI_Comm_group(node_comm_, &node_group);
+        int root = 0;
+        int node_root = MPI_UNDEFINED;
+        MPI_Group_translate_ranks(group, 1, &root, node_group, &node_root);
+        MPI_Group_free(&group);
+        MPI_Group_free(&node_group);
+        local_ = node_root != MPI_UNDEFINED;
+        
+        MPI_Aint bytes = rank == 0 ? static_cast<MPI_Aint>(count) * sizeof(int) : 0;
+        int* base = nullptr;
+        MPI_Win_allocate_shared(bytes, sizeof(int), MPI_INFO_NULL, node_comm_, &base, &win_);
+        
+        if (local_) {
+            MPI_Aint root_bytes;
+            int disp_unit;
+            MPI_Win_shared_query(win_, node_root, &root_bytes, &disp_unit, &data_);
+        }
+        if (rank == 0) {
+            std::fill_n(data_, count, 0);
+        }
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, win_);
+        
+        int flag = local_ ? 1 : 0;
+        shared_.resize(size);
+        MPI_Allgather(&flag, 1, MPI_INT, shared_.data(), 1, MPI_INT, comm);
+    }
+    
+    ~MpiSharedBoard() override {
+        MPI_Win_unlock_all(win_);
+        MPI_Win_free(&win_);
+        MPI_Comm_free(&node_comm_);
+    }
+    
+    bool isLocal() const override { return local_; }
+    bool sharedWith(int rank) const override { return shared_[rank] != 0; }
+    int* data() override { return data_; }
+    
+    void sync() override {
+        MPI_Win_sync(win_);
+    }
+    
+private:
+    MPI_Comm node_comm_;
+    MPI_Win win_;
+    int* data_;
+    bool local_;
+    std::vector<int> shared_;
+};
+
+} // namespace
+
+std::unique_ptr<SharedBoard> MpiTransport::allocateSharedBoard(int count) {
+    return std::make_unique<MpiSharedBoard>(comm_, count);
+}
+
+void MpiTransport::writeAtAll(const std::string& path, long long offset,
+                              const int* data, int count, long long file_size) {
+    MPI_File file;
+    int rc = MPI_File_open(comm_, path.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                           MPI_INFO_NULL, &file);
+    if (rc != MPI_SUCCESS) {
+        throw std::runtime_error("Cannot open output file: " + path);
+    }
+    
+    // Коллективные вызовы выполняются всеми процессами даже после ошибки,
+    // иначе остальные зависнут в write_at_all; ошибка бросается после close
+    const char* failed = nullptr;
+    rc = MPI_File_set_size(file, static_cast<MPI_Offset>(file_size));
+    if (rc != MPI_SUCCESS) {
+        failed = "Cannot resize output file: ";
+    }
+    rc = MPI_File_write_at_all(file, static_cast<MPI_Offset>(offset), data, count, MPI_INT,
+                               MPI_STATUS_IGNORE);
+    if (rc != MPI_SUCCESS && failed == nullptr) {
+        failed = "Cannot write output file: ";
+    }
+    rc = MPI_File_close(&file);
+    if (rc != MPI_SUCCESS && failed == nullptr) {
+        failed = "Cannot close output file: ";
+    }
+    if (failed != nullptr) {
+        throw std::runtime_error(failed + path);
+    }
+}
+
+// Конструктор по умолчанию работает через MPI_COMM_WORLD. Определен здесь,
+// чтобы CityCapture.cpp не зависел от MPI и собирался в локальном режиме.
+CityCapture::CityCapture(int num_cities, const CaptureOptions& options)
+    : CityCapture(num_cities, options, std::make_shared<MpiTransport>()) {}
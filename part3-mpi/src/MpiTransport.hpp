@@ -0,0 +1,42 @@
+#ifndef MPI_TRANSPORT_HPP
+#define MPI_TRANSPORT_HPP
+
+#include "CaptureTransport.hpp"
+#include <mpi.h>
+
+// Обмен через MPI поверх заданного коммуникатора
+class MpiTransport : public CaptureTransport {
+public:
+    explicit MpiTransport(MPI_Comm comm = MPI_COMM_WORLD);
+    
+    int rank() const override { return rank_; }
+    int size() const override { return size_; }
+    double now() const override;
+    
+    void send(const int* data, int count, int dest, int tag) override;
+    void recv(int* data, int count, int source, int tag) override;
+    
+    std::unique_ptr<PersistentRequest> sendInit(const int* data, int count,
+                                                int dest, int tag) override;
+    std::unique_ptr<PersistentRequest> recvInit(int* data, int count,
+                                                int source, int tag) override;
+    
+    void barrier() override;
+    void broadcast(int* data, int count, int root) override;
+    void allreduceMin(std::uint64_t* data, int count) override;
+    void allreduceSum(std::uint64_t* data, int count) override;
+    void allreduceMax(double* data, int count) override;
+    std::string gatherBytes(const std::string& local, int root) override;
+    std::unique_ptr<SharedBoard> allocateSharedBoard(int count) override;
+    void writeAtAll(const std::string& path, long long offset,
+                    const int* data, int count, long long file_size) override;
+    
+    std::string name() const override { return "mpi"; }
+    
+private:
+    MPI_Comm comm_;
+    int rank_;
+    int size_;
+};
+
+#endif // MPI_TRANSPORT_HPP
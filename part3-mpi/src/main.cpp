@@ -1,5 +1,8 @@
 #include "CityCapture.hpp"
+#include "MpiTransport.hpp"
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <mpi.h>
 
 int main(int argc, char* argv[]) {
@@ -10,51 +13,66 @@ int main(int argc, char* argv[]) {
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &world_size);
     
+    // Определяем количество городов (по умолчанию 20) и параметры.
+    // Разбор одинаков на всех процессах, при ошибке все выходят сами
+    int num_cities = 20;
+    CaptureOptions options;
     try {
-        // Определяем количество городов (по умолчанию 20)
-        int num_cities = 20;
+        CityCapture::parseCommandLine(argc, argv, num_cities, options, world_rank == 0);
+    } catch (const std::invalid_argument&) {
+        MPI_Finalize();
+        return 1;
+    }
+    
+    try {
+        // Лишние процессы (больше, чем городов + командующий) выделяются
+        // из коммуникатора и сразу завершаются, не участвуя в барьерах.
+        // При нехватке процессов каждый ведет несколько городов.
+        int active = world_rank <= num_cities ? 0 : MPI_UNDEFINED;
+        MPI_Comm city_comm;
+        MPI_Comm_split(MPI_COMM_WORLD, active, world_rank, &city_comm);
         
-        if (argc > 1) {
-            num_cities = std::atoi(argv[1]);
-            if (num_cities < 2 || num_cities > 50) {
-                if (world_rank == 0) {
-                    std::cerr << "Invalid number of cities. Using default: 20" << std::endl;
-                }
-                num_cities = 20;
-            }
+        if (city_comm == MPI_COMM_NULL) {
+            MPI_Finalize();
+            return 0;
         }
         
-        // Проверяем количество процессов
-        if (world_rank == 0 && world_size != num_cities + 1) {
-            std::cout << "Warning: Running with " << world_size 
-                      << " processes, but " << (num_cities + 1)
-                      << " recommended (cities + commander)" << std::endl;
-            std::cout << "Some processes may be idle." << std::endl;
+        if (world_rank == 0 && world_size > num_cities + 1) {
+            std::cout << "Note: " << (world_size - num_cities - 1)
+                      << " surplus process(es) exit early" << std::endl;
         }
         
         // Создаем симулятор
-        CityCapture simulator(num_cities);
+        CityCapture simulator(num_cities, options, std::make_shared<MpiTransport>(city_comm));
         
         // Запускаем симуляцию
         simulator.simulateCapture();
         
         // Выводим результаты
-        if (world_rank == 0) {
-            simulator.printResults();
-            
-            // Проверяем корректность
+        simulator.printResults();
+        
+        if (simulator.getCompletedSteps() < num_cities) {
+            if (world_rank == 0) {
+                std::cout << "\nSimulation stopped after step " << simulator.getCompletedSteps()
+                          << ". Resume with --restart." << std::endl;
+            }
+        } else {
+            // Проверяем корректность (коллективно: города отправляют свои данные)
             bool valid = simulator.validateResults();
             
-            std::cout << "\n=== Validation ===" << std::endl;
-            if (valid) {
-                std::cout << "✓ SUCCESS: All cities have complete cipher!" << std::endl;
-                std::cout << "The resistance army has achieved full victory!" << std::endl;
-            } else {
-                std::cout << "✗ FAILURE: Not all cities have complete cipher." << std::endl;
-                std::cout << "The cipher transmission failed!" << std::endl;
+            if (world_rank == 0) {
+                std::cout << "\n=== Validation ===" << std::endl;
+                if (valid) {
+                    std::cout << "✓ SUCCESS: All cities have complete cipher!" << std::endl;
+                    std::cout << "The resistance army has achieved full victory!" << std::endl;
+                } else {
+                    std::cout << "✗ FAILURE: Not all cities have complete cipher." << std::endl;
+                    std::cout << "The cipher transmission failed!" << std::endl;
+                }
             }
         }
         
+        MPI_Comm_free(&city_comm);
     } catch (const std::exception& e) {
         if (world_rank == 0) {
             std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,145 @@
+#include "CaptureBenchmark.hpp"
+#include "LocalTransport.hpp"
+#include "MpiTransport.hpp"
+#include <mpi.h>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Замер одной конфигурации: количество процессов задает mpirun -np,
+// количество городов - аргумент. Перебор конфигураций - run_benchmark.sh.
+// С --transport local замер идет на потоках процесса 0 (город - поток),
+// тем же методом и в те же отчеты, что и для MPI
+int main(int argc, char* argv[]) {
+    MPI_Init(&argc, &argv);
+    
+    int world_rank, world_size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    
+    // Параметры замера; остальные аргументы разбирает CityCapture
+    int repetitions = 5;
+    std::string csv_file;
+    std::string json_file;
+    std::string label = "unlabeled";
+    std::string transport_name = "mpi";
+    std::vector<char*> capture_args = {argv[0]};
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool bench_flag = arg == "--repetitions" || arg == "--csv" ||
+                          arg == "--json" || arg == "--label" || arg == "--transport";
+        if (bench_flag && i + 1 >= argc) {
+            if (world_rank == 0) {
+                std::cerr << "Missing value for " << arg << std::endl;
+            }
+            MPI_Finalize();
+            return 1;
+        }
+        
+        if (arg == "--repetitions") {
+            repetitions = std::atoi(argv[++i]);
+        } else if (arg == "--csv") {
+            csv_file = argv[++i];
+        } else if (arg == "--json") {
+            json_file = argv[++i];
+        } else if (arg == "--label") {
+            label = argv[++i];
+        } else if (arg == "--transport") {
+            transport_name = argv[++i];
+        } else {
+            capture_args.push_back(argv[i]);
+        }
+    }
+    
+    // По умолчанию: все процессы заняты (локально - 20 городов, как
+    // в city_capture_local), журнал выключен, порядок фиксирован зерном,
+    // чтобы замеры разных коммитов были сравнимы
+    int num_cities = transport_name == "local" ? 20 : world_size - 1;
+    CaptureOptions options;
+    options.log_level = LogLevel::Off;
+    options.seed = 2024;
+    options.validation = ValidationMode::Allreduce;
+    options.quiet = true;
+    
+    try {
+        CityCapture::parseCommandLine(static_cast<int>(capture_args.size()), capture_args.data(),
+                                      num_cities, options, world_rank == 0);
+    } catch (const std::invalid_argument&) {
+        MPI_Finalize();
+        return 1;
+    }
+    
+    if (transport_name != "mpi" && transport_name != "local") {
+        if (world_rank == 0) {
+            std::cerr << "Unknown transport: " << transport_name << " (mpi or local)" << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    // Замеряются только активные процессы, лишние сразу завершаются.
+    // Локальному транспорту нужен один процесс: потоки-ранги внутри него
+    bool local = transport_name == "local";
+    MPI_Comm city_comm;
+    MPI_Comm_split(MPI_COMM_WORLD,
+                   (local ? world_rank == 0 : world_rank <= num_cities) ? 0 : MPI_UNDEFINED,
+                   world_rank, &city_comm);
+    if (city_comm == MPI_COMM_NULL) {
+        MPI_Finalize();
+        return 0;
+    }
+    
+    int status = 0;
+    try {
+        CaptureBenchmarkResult result;
+        if (local) {
+            // Наибольшее сообщение - полный шифр города
+            LocalFabric::run(num_cities + 1, num_cities,
+                             [&](std::shared_ptr<CaptureTransport> transport) {
+                CaptureBenchmarkResult rank_result = runCaptureBenchmark(
+                    transport, num_cities, repetitions, options, label);
+                if (transport->rank() == 0) {
+                    result = rank_result;
+                }
+            });
+        } else {
+            auto transport = std::make_shared<MpiTransport>(city_comm);
+            result = runCaptureBenchmark(transport, num_cities, repetitions, options, label);
+        }
+        
+        if (world_rank == 0) {
+            std::cout << std::fixed << std::setprecision(3)
+                      << "transport=" << result.transport
+                      << " np=" << world_size
+                      << " active=" << result.processes
+                      << " cities=" << result.cities
+                      << " mode=" << result.mode
+                      << " median=" << result.median_ms << " ms"
+                      << " min=" << result.min_ms << " ms"
+                      << " mean_step=" << std::setprecision(1) << result.mean_step_us << " us"
+                      << " messages=" << result.messages
+                      << " msg/s=" << std::setprecision(0) << result.messages_per_second
+                      << (result.valid ? "" : " INVALID") << std::endl;
+            
+            if (!csv_file.empty()) {
+                appendBenchmarkCSV({result}, csv_file);
+            }
+            if (!json_file.empty()) {
+                appendBenchmarkJSON({result}, json_file);
+            }
+        }
+        
+        status = result.valid ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error on rank " << world_rank << ": " << e.what() << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    
+    MPI_Comm_free(&city_comm);
+    MPI_Finalize();
+    return status;
+}
@@ -0,0 +1,56 @@
+#include "CityCapture.hpp"
+#include "LocalTransport.hpp"
+#include <iostream>
+#include <stdexcept>
+
+// Запуск симуляции внутри одного процесса без MPI: каждый город
+// и командующий - отдельный поток, обмен через очереди в общей памяти
+int main(int argc, char* argv[]) {
+    // Определяем количество городов (по умолчанию 20) и параметры
+    int num_cities = 20;
+    CaptureOptions options;
+    try {
+        CityCapture::parseCommandLine(argc, argv, num_cities, options, true);
+    } catch (const std::invalid_argument&) {
+        return 1;
+    }
+    
+    try {
+        // Наибольшее сообщение - полный шифр города
+        LocalFabric::run(num_cities + 1, num_cities,
+                         [&](std::shared_ptr<CaptureTransport> transport) {
+            int rank = transport->rank();
+            
+            CityCapture simulator(num_cities, options, transport);
+            simulator.simulateCapture();
+            simulator.printResults();
+            
+            if (simulator.getCompletedSteps() < num_cities) {
+                if (rank == 0) {
+                    std::cout << "\nSimulation stopped after step " << simulator.getCompletedSteps()
+                              << ". Resume with --restart." << std::endl;
+                }
+                return;
+            }
+            
+            bool valid = simulator.validateResults();
+            
+            if (rank == 0) {
+                std::cout << "\n=== Validation ===" << std::endl;
+                if (valid) {
+                    std::cout << "✓ SUCCESS: All cities have complete cipher!" << std::endl;
+                    std::cout << "The resistance army has achieved full victory!" << std::endl;
+                } else {
+                    std::cout << "✗ FAILURE: Not all cities have complete cipher." << std::endl;
+                    std::cout << "The cipher transmission failed!" << std::endl;
+                }
+            }
+        });
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -1,7 +1,20 @@
 #include "CityCapture.hpp"
+#include "LocalTransport.hpp"
+#include "CaptureBenchmark.hpp"
+#include "MpiTransport.hpp"
 #include <gtest/gtest.h>
 #include <mpi.h>
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
 
 class CityCaptureTest : public ::testing::Test {
 protected:
@@ -16,11 +29,7 @@ protected:
     }
     
     static void TearDownTestCase() {
-        int finalized;
-        MPI_Finalized(&finalized);
-        if (!finalized) {
-            MPI_Finalize();
-        }
+        // MPI_Finalize вызывается в main после всех тестов
     }
     
     void SetUp() override {
@@ -28,6 +37,32 @@ protected:
         MPI_Comm_size(MPI_COMM_WORLD, &world_size_);
     }
     
+    // Временный файл или каталог /tmp/<prefix>_XXXXXX, созданный процессом 0,
+    // с путем на всех процессах. Bcast выполняется всегда, поэтому ошибка
+    // не оставляет остальных ждать: путь пуст на всех и тест проваливается
+    std::string sharedTempPath(const std::string& prefix, bool directory) {
+        char path[256] = {};
+        if (world_rank_ == 0) {
+            std::snprintf(path, sizeof(path), "/tmp/%s_XXXXXX", prefix.c_str());
+            bool created = false;
+            if (directory) {
+                created = mkdtemp(path) != nullptr;
+            } else {
+                int fd = mkstemp(path);
+                created = fd >= 0;
+                if (created) {
+                    close(fd);
+                }
+            }
+            if (!created) {
+                ADD_FAILURE() << "Cannot create temporary path for " << prefix;
+                path[0] = '\0';
+            }
+        }
+        MPI_Bcast(path, sizeof(path), MPI_CHAR, 0, MPI_COMM_WORLD);
+        return path;
+    }
+    
     int world_rank_;
     int world_size_;
 };
@@ -47,6 +82,34 @@ TEST_F(CityCaptureTest, CipherGeneration) {
     }
 }
 
+TEST_F(CityCaptureTest, ParseCommandLineRejectsUnknownOptions) {
+    // Разбор без вывода: достаточно, что ошибка не меняет число городов
+    auto parse = [](std::vector<std::string> args, int& num_cities, CaptureOptions& options) {
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(&arg[0]);
+        }
+        CityCapture::parseCommandLine(static_cast<int>(argv.size()), argv.data(),
+                                      num_cities, options, false);
+    };
+    
+    int num_cities = 20;
+    CaptureOptions options;
+    parse({"city_capture", "7", "--seed", "42", "--restart"}, num_cities, options);
+    EXPECT_EQ(num_cities, 7);
+    EXPECT_EQ(options.seed, 42);
+    EXPECT_TRUE(options.restart);
+    
+    num_cities = 20;
+    EXPECT_THROW(parse({"city_capture", "--label", "5"}, num_cities, options),
+                 std::invalid_argument);
+    EXPECT_THROW(parse({"city_capture", "--seed"}, num_cities, options),
+                 std::invalid_argument);
+    EXPECT_THROW(parse({"city_capture", "7x"}, num_cities, options),
+                 std::invalid_argument);
+    EXPECT_EQ(num_cities, 20);
+}
+
 TEST_F(CityCaptureTest, BasicSimulation) {
     // Этот тест требует определенного количества процессов
     // Запускается только с правильным количеством
@@ -64,6 +127,511 @@ TEST_F(CityCaptureTest, BasicSimulation) {
     }
 }
 
+TEST_F(CityCaptureTest, CheckpointRestartResumesSimulation) {
+    // Один процесс на каждый город плюс командующий
+    if (world_size_ < 3) {
+        SUCCEED();
+        return;
+    }
+    int num_cities = world_size_ - 1;
+    
+    // Общий каталог для контрольных точек всех процессов
+    std::string directory = sharedTempPath("city_capture_ckpt", true);
+    ASSERT_FALSE(directory.empty());
+    
+    CaptureOptions options;
+    options.checkpoint_dir = directory;
+    options.checkpoint_interval = 1;
+    options.halt_after_step = 0;  // "Сбой" после первого шага
+    
+    CityCapture interrupted(num_cities, options);
+    interrupted.simulateCapture();
+    EXPECT_EQ(interrupted.getCompletedSteps(), 1);
+    
+    options.restart = true;
+    options.halt_after_step = -1;
+    
+    CityCapture resumed(num_cities, options);
+    resumed.simulateCapture();
+    EXPECT_EQ(resumed.getStartStep(), 1);
+    EXPECT_EQ(resumed.getCompletedSteps(), num_cities);
+    
+    bool valid = resumed.validateResults();
+    if (world_rank_ == 0) {
+        EXPECT_TRUE(valid);
+        EXPECT_GE(resumed.getCheckpointTime(), 0.0);
+        std::string cleanup = std::string("rm -rf ") + directory;
+        EXPECT_EQ(std::system(cleanup.c_str()), 0);
+    }
+}
+
+TEST_F(CityCaptureTest, CipherMatrixWrittenWithMPIIO) {
+    if (world_size_ < 3) {
+        SUCCEED();
+        return;
+    }
+    int num_cities = world_size_ - 1;
+    
+    std::string path = sharedTempPath("city_capture_matrix", false);
+    ASSERT_FALSE(path.empty());
+    
+    CaptureOptions options;
+    options.output_file = path;
+    
+    CityCapture capture(num_cities, options);
+    capture.simulateCapture();
+    
+    if (world_rank_ == 0) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<int> matrix(num_cities * num_cities, 0);
+        ASSERT_TRUE(in.read(reinterpret_cast<char*>(matrix.data()),
+                            matrix.size() * sizeof(int)));
+        EXPECT_EQ(in.peek(), EOF);
+        
+        // Все строки содержат одинаковый набор частей шифра
+        std::vector<int> first(matrix.begin(), matrix.begin() + num_cities);
+        std::sort(first.begin(), first.end());
+        for (int city = 1; city < num_cities; ++city) {
+            std::vector<int> row(matrix.begin() + city * num_cities,
+                                 matrix.begin() + (city + 1) * num_cities);
+            std::sort(row.begin(), row.end());
+            EXPECT_EQ(row, first);
+        }
+        std::remove(path.c_str());
+    }
+}
+
+TEST_F(CityCaptureTest, PerRankLogFiles) {
+    if (world_size_ < 3) {
+        SUCCEED();
+        return;
+    }
+    int num_cities = world_size_ - 1;
+    
+    CaptureOptions options;
+    options.log_mode = LogMode::PerRankFile;
+    options.log_level = LogLevel::Debug;
+    options.log_prefix = "/tmp/city_capture_test_" + std::to_string(getppid());
+    
+    std::string log_file = options.log_prefix + ".rank" + std::to_string(world_rank_) + ".log";
+    std::remove(log_file.c_str());
+    
+    CityCapture capture(num_cities, options);
+    capture.simulateCapture();
+    
+    std::ifstream in(log_file);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+#ifdef CITY_CAPTURE_NO_LOGGING
+    EXPECT_TRUE(content.empty());
+#else
+    std::string tag = world_rank_ == 0 ? "[Commander]" : "[City";
+    EXPECT_NE(content.find(tag), std::string::npos);
+#endif
+    std::remove(log_file.c_str());
+}
+
+TEST_F(CityCaptureTest, SeededRunsAreReproducible) {
+    if (world_size_ < 3) {
+        SUCCEED();
+        return;
+    }
+    int num_cities = world_size_ - 1;
+    
+    std::vector<std::vector<int>> matrices;
+    for (int run = 0; run < 2; ++run) {
+        std::string path = sharedTempPath("city_capture_seeded", false);
+        ASSERT_FALSE(path.empty());
+        
+        CaptureOptions options;
+        options.seed = 2024;
+        options.output_file = path;
+        
+        CityCapture capture(num_cities, options);
+        capture.simulateCapture();
+        
+        // Содержимое проверяется по контрольной сумме, а не только по размеру
+        bool valid = capture.validateResults();
+        EXPECT_TRUE(valid);
+        
+        if (world_rank_ == 0) {
+            std::ifstream in(path, std::ios::binary);
+            std::vector<int> matrix(num_cities * num_cities, 0);
+            EXPECT_TRUE(in.read(reinterpret_cast<char*>(matrix.data()),
+                                matrix.size() * sizeof(int)));
+            matrices.push_back(matrix);
+            std::remove(path.c_str());
+        }
+    }
+    
+    if (world_rank_ == 0) {
+        ASSERT_EQ(matrices.size(), 2u);
+        EXPECT_EQ(matrices[0], matrices[1]);
+    }
+}
+
+TEST_F(CityCaptureTest, AllreduceValidationAgreesOnAllRanks) {
+    if (world_size_ < 3) {
+        SUCCEED();
+        return;
+    }
+    int num_cities = world_size_ - 1;
+    
+    CaptureOptions options;
+    options.validation = ValidationMode::Allreduce;
+    
+    CityCapture capture(num_cities, options);
+    capture.simulateCapture();
+    
+    // Результат MPI_Allreduce одинаков на каждом процессе
+    EXPECT_TRUE(capture.validateResults());
+    
+    // С зерном дополнительно сверяется ожидаемая контрольная сумма
+    options.seed = 99;
+    CityCapture seeded(num_cities, options);
+    seeded.simulateCapture();
+    EXPECT_TRUE(seeded.validateResults());
+}
+
+TEST_F(CityCaptureTest, AllreduceValidationDetectsIncompleteRun) {
+    if (world_size_ < 3) {
+        SUCCEED();
+        return;
+    }
+    int num_cities = world_size_ - 1;
+    
+    CaptureOptions options;
+    options.validation = ValidationMode::Allreduce;
+    options.halt_after_step = 0;
+    
+    CityCapture capture(num_cities, options);
+    capture.simulateCapture();
+    EXPECT_FALSE(capture.validateResults());
+}
+
+TEST_F(CityCaptureTest, LocalTransportRunsWithoutMPI) {
+    // Каждый процесс теста независимо запускает симуляцию на потоках
+    int num_cities = 5;
+    
+    CaptureOptions options;
+    options.seed = 11;
+    options.log_level = LogLevel::Off;
+    
+    std::atomic<int> valid_ranks(0);
+    LocalFabric::run(num_cities + 1, num_cities,
+                     [&](std::shared_ptr<CaptureTransport> transport) {
+        CityCapture capture(num_cities, options, transport);
+        capture.simulateCapture();
+        
+        EXPECT_EQ(capture.getCompletedSteps(), num_cities);
+        if (capture.validateResults()) {
+            ++valid_ranks;
+        }
+    });
+    
+    EXPECT_EQ(valid_ranks.load(), num_cities + 1);
+}
+
+TEST_F(CityCaptureTest, BenchmarkCountsMessagesAndWritesReports) {
+    int num_cities = 4;
+    
+    CaptureOptions options;
+    options.seed = 5;
+    options.log_level = LogLevel::Off;
+    options.validation = ValidationMode::Allreduce;
+    options.quiet = true;
+    
+    std::vector<CaptureBenchmarkResult> results(num_cities + 1);
+    LocalFabric::run(num_cities + 1, num_cities,
+                     [&](std::shared_ptr<CaptureTransport> transport) {
+        results[transport->rank()] = runCaptureBenchmark(transport, num_cities, 3,
+                                                         options, "test");
+    });
+    
+    const CaptureBenchmarkResult& result = results[0];
+    EXPECT_TRUE(result.valid);
+    EXPECT_EQ(result.processes, num_cities + 1);
+    EXPECT_EQ(result.transport, "local");
+    EXPECT_GT(result.median_ms, 0.0);
+    EXPECT_LE(result.min_ms, result.median_ms);
+    
+    // На шаге s: захват, часть шифра, известные части (при s > 0) и s
+    // новых частей; плюс итоговый сбор шифров у командующего
+    std::uint64_t expected = 0;
+    for (int step = 0; step < num_cities; ++step) {
+        expected += 2 + step + (step > 0 ? 1 : 0);
+    }
+    expected += num_cities;
+    EXPECT_EQ(result.messages, expected);
+    
+    // Итог одинаков на всех процессах
+    for (const auto& other : results) {
+        EXPECT_EQ(other.messages, result.messages);
+        EXPECT_DOUBLE_EQ(other.median_ms, result.median_ms);
+    }
+    
+    // Отчеты дописываются: заголовок CSV один, по строке на запуск
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::string csv = "bench_test_rank" + std::to_string(rank) + ".csv";
+    std::string json = "bench_test_rank" + std::to_string(rank) + ".jsonl";
+    std::remove(csv.c_str());
+    std::remove(json.c_str());
+    
+    appendBenchmarkCSV({result}, csv);
+    appendBenchmarkCSV({result}, csv);
+    appendBenchmarkJSON({result}, json);
+    
+    std::ifstream csv_in(csv);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(csv_in, line);) {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0].rfind("label,transport,mode,processes,cities", 0), 0u);
+    EXPECT_EQ(lines[1].rfind("test,local,blocking,5,4,3,", 0), 0u);
+    
+    std::ifstream json_in(json);
+    std::string json_line;
+    std::getline(json_in, json_line);
+    EXPECT_NE(json_line.find("\"messages\":" + std::to_string(expected)), std::string::npos);
+    
+    std::remove(csv.c_str());
+    std::remove(json.c_str());
+}
+
+TEST_F(CityCaptureTest, FewerProcessesThanCities) {
+    if (world_size_ < 2) {
+        SUCCEED();
+        return;
+    }
+    // Каждый процесс ведет несколько городов
+    int num_cities = 2 * world_size_ + 1;
+    
+    CaptureOptions options;
+    options.seed = 17;
+    options.log_level = LogLevel::Off;
+    
+    CityCapture capture(num_cities, options);
+    capture.simulateCapture();
+    EXPECT_EQ(capture.getCompletedSteps(), num_cities);
+    EXPECT_TRUE(capture.validateResults());
+    
+    options.validation = ValidationMode::Allreduce;
+    CityCapture reduced(num_cities, options);
+    reduced.simulateCapture();
+    EXPECT_TRUE(reduced.validateResults());
+    
+    // Строки матрицы пишутся блоками по процессам
+    std::string path = sharedTempPath("city_capture_matrix", false);
+    ASSERT_FALSE(path.empty());
+    
+    options.output_file = path;
+    CityCapture written(num_cities, options);
+    written.simulateCapture();
+    
+    if (world_rank_ == 0) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<int> matrix(num_cities * num_cities, 0);
+        ASSERT_TRUE(in.read(reinterpret_cast<char*>(matrix.data()),
+                            matrix.size() * sizeof(int)));
+        EXPECT_EQ(in.peek(), EOF);
+        
+        std::vector<int> first(matrix.begin(), matrix.begin() + num_cities);
+        std::sort(first.begin(), first.end());
+        EXPECT_NE(first.front(), 0);
+        for (int city = 1; city < num_cities; ++city) {
+            std::vector<int> row(matrix.begin() + city * num_cities,
+                                 matrix.begin() + (city + 1) * num_cities);
+            std::sort(row.begin(), row.end());
+            EXPECT_EQ(row, first);
+        }
+        std::remove(path.c_str());
+    }
+}
+
+TEST_F(CityCaptureTest, SurplusProcessesSplitOff) {
+    if (world_size_ < 3) {
+        SUCCEED();
+        return;
+    }
+    int num_cities = world_size_ - 2;
+    
+    // Последний процесс лишний: он не входит в коммуникатор городов
+    MPI_Comm city_comm;
+    MPI_Comm_split(MPI_COMM_WORLD, world_rank_ <= num_cities ? 0 : MPI_UNDEFINED,
+                   world_rank_, &city_comm);
+    if (city_comm == MPI_COMM_NULL) {
+        EXPECT_EQ(world_rank_, world_size_ - 1);
+        return;
+    }
+    
+    CaptureOptions options;
+    options.seed = 23;
+    options.validation = ValidationMode::Allreduce;
+    
+    CityCapture capture(num_cities, options, std::make_shared<MpiTransport>(city_comm));
+    capture.simulateCapture();
+    EXPECT_TRUE(capture.validateResults());
+    
+    MPI_Comm_free(&city_comm);
+}
+
+TEST_F(CityCaptureTest, LocalTransportWithFewThreads) {
+    int num_cities = 10;
+    
+    CaptureOptions options;
+    options.seed = 29;
+    options.log_level = LogLevel::Off;
+    options.quiet = true;
+    
+    std::atomic<int> valid_ranks(0);
+    LocalFabric::run(3, num_cities, [&](std::shared_ptr<CaptureTransport> transport) {
+        CityCapture capture(num_cities, options, transport);
+        capture.simulateCapture();
+        if (capture.validateResults()) {
+            ++valid_ranks;
+        }
+    });
+    
+    EXPECT_EQ(valid_ranks.load(), 3);
+}
+
+TEST_F(CityCaptureTest, LocalTransportFailureAbortsOtherRanks) {
+    // Сбой одного ранга не оставляет остальных ждать в барьере и приеме
+    EXPECT_THROW(LocalFabric::run(3, 4, [](std::shared_ptr<CaptureTransport> transport) {
+        if (transport->rank() == 1) {
+            throw std::logic_error("rank 1 failed");
+        }
+        if (transport->rank() == 2) {
+            int value = 0;
+            transport->recv(&value, 1, 1, 0);
+        }
+        transport->barrier();
+    }), std::logic_error);
+}
+
+TEST_F(CityCaptureTest, PersistentRequestsMatchBlockingMode) {
+    if (world_size_ < 2) {
+        SUCCEED();
+        return;
+    }
+    // Больше городов, чем процессов: запросы перезапускаются многократно
+    int num_cities = 3 * world_size_;
+    
+    CaptureOptions options;
+    options.seed = 31;
+    options.log_level = LogLevel::Off;
+    options.persistent = true;
+    
+    CityCapture capture(num_cities, options);
+    capture.simulateCapture();
+    EXPECT_TRUE(capture.validateResults());
+    
+    // Восстановление с контрольной точки в постоянном режиме
+    std::string directory = sharedTempPath("city_capture_persistent", true);
+    ASSERT_FALSE(directory.empty());
+    
+    options.checkpoint_dir = directory;
+    options.checkpoint_interval = 2;
+    options.halt_after_step = num_cities / 2;
+    CityCapture halted(num_cities, options);
+    halted.simulateCapture();
+    
+    options.restart = true;
+    options.halt_after_step = -1;
+    CityCapture resumed(num_cities, options);
+    resumed.simulateCapture();
+    EXPECT_GT(resumed.getStartStep(), 0);
+    EXPECT_TRUE(resumed.validateResults());
+    
+    // Локальная эмуляция постоянных запросов
+    options = CaptureOptions();
+    options.seed = 31;
+    options.log_level = LogLevel::Off;
+    options.quiet = true;
+    options.persistent = true;
+    
+    std::atomic<int> valid_ranks(0);
+    LocalFabric::run(3, num_cities, [&](std::shared_ptr<CaptureTransport> transport) {
+        CityCapture local(num_cities, options, transport);
+        local.simulateCapture();
+        if (local.validateResults()) {
+            ++valid_ranks;
+        }
+    });
+    EXPECT_EQ(valid_ranks.load(), 3);
+    
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (world_rank_ == 0) {
+        std::string cleanup = std::string("rm -rf ") + directory;
+        EXPECT_EQ(std::system(cleanup.c_str()), 0);
+    }
+}
+
+TEST_F(CityCaptureTest, SharedMemoryBoardMatchesMessaging) {
+    if (world_size_ < 2) {
+        SUCCEED();
+        return;
+    }
+    int num_cities = 2 * world_size_;
+    
+    CaptureOptions options;
+    options.seed = 37;
+    options.log_level = LogLevel::Off;
+    options.shared_memory = true;
+    
+    CityCapture capture(num_cities, options);
+    capture.simulateCapture();
+    EXPECT_TRUE(capture.validateResults());
+    
+    // Вместе с постоянными запросами и проверкой через MPI_Allreduce
+    options.persistent = true;
+    options.validation = ValidationMode::Allreduce;
+    CityCapture combined(num_cities, options);
+    combined.simulateCapture();
+    EXPECT_TRUE(combined.validateResults());
+    
+    // Восстановление: доска заполняется частями из контрольной точки
+    std::string directory = sharedTempPath("city_capture_shared", true);
+    ASSERT_FALSE(directory.empty());
+    
+    options.checkpoint_dir = directory;
+    options.checkpoint_interval = 3;
+    options.halt_after_step = num_cities / 2;
+    CityCapture halted(num_cities, options);
+    halted.simulateCapture();
+    
+    options.restart = true;
+    options.halt_after_step = -1;
+    CityCapture resumed(num_cities, options);
+    resumed.simulateCapture();
+    EXPECT_GT(resumed.getStartStep(), 0);
+    EXPECT_TRUE(resumed.validateResults());
+    
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (world_rank_ == 0) {
+        std::string cleanup = std::string("rm -rf ") + directory;
+        EXPECT_EQ(std::system(cleanup.c_str()), 0);
+    }
+    
+    // Потоки локального транспорта читают одну доску
+    CaptureOptions local_options;
+    local_options.seed = 37;
+    local_options.log_level = LogLevel::Off;
+    local_options.quiet = true;
+    local_options.shared_memory = true;
+    
+    std::atomic<int> valid_ranks(0);
+    LocalFabric::run(4, num_cities, [&](std::shared_ptr<CaptureTransport> transport) {
+        CityCapture local(num_cities, local_options, transport);
+        local.simulateCapture();
+        if (local.validateResults()) {
+            ++valid_ranks;
+        }
+    });
+    EXPECT_EQ(valid_ranks.load(), 4);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     